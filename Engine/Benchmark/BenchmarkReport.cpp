@@ -0,0 +1,425 @@
+#include "BenchmarkReport.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <set>
+#include <cstring>
+
+#if defined( _WIN32 )
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment( lib, "psapi.lib" )
+#else
+#include <sys/resource.h>
+#endif
+
+Percentiles Percentiles::From( std::vector<double> samples )
+{
+	Percentiles p;
+	if( samples.empty() )
+		return p;
+
+	std::sort( samples.begin(), samples.end() );
+	auto rank = [&samples]( double q )
+	{
+		const size_t index = static_cast<size_t>( std::ceil( q * samples.size() ) );
+		return samples[std::min( samples.size() - 1, index > 0 ? index - 1 : 0 )];
+	};
+
+	double sum = 0.0;
+	for( double s : samples )
+		sum += s;
+
+	p.mean = sum / samples.size();
+	p.p50 = rank( 0.50 );
+	p.p90 = rank( 0.90 );
+	p.p99 = rank( 0.99 );
+	p.max = samples.back();
+	return p;
+}
+
+// --- JSON WRITER ---
+// -------------------
+static std::string Quoted( const std::string& s )
+{
+	std::string r = "\"";
+	for( char c : s )
+	{
+		if( c == '"' || c == '\\' )
+			r += '\\';
+		if( static_cast<unsigned char>( c ) < 0x20 )
+			continue;
+		r += c;
+	}
+	return r + "\"";
+}
+
+static void WritePercentiles( std::ostream& out, const Percentiles& p )
+{
+	out << "{ \"mean\": " << p.mean << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90
+		<< ", \"p99\": " << p.p99 << ", \"max\": " << p.max << " }";
+}
+
+void BenchmarkReport::WriteJson( std::ostream& out ) const
+{
+	out << std::setprecision( 9 );
+	out << "{\n";
+	out << "  \"deviceName\": " << Quoted( deviceName ) << ",\n";
+	out << "  \"simdLevel\": " << Quoted( simdLevel ) << ",\n";
+	out << "  \"timelineSemaphores\": " << ( timelineSemaphores ? "true" : "false" ) << ",\n";
+	out << "  \"startupMs\": " << startupMs << ",\n";
+	out << "  \"peakHostMemoryBytes\": " << peakHostMemoryBytes << ",\n";
+	out << "  \"scenes\": [\n";
+	for( size_t i = 0; i < scenes.size(); ++i )
+	{
+		const SceneResult& s = scenes[i];
+		out << "    {\n";
+		out << "      \"name\": " << Quoted( s.name ) << ",\n";
+		out << "      \"seed\": " << s.seed << ",\n";
+		out << "      \"frames\": " << s.frames << ",\n";
+		out << "      \"objects\": " << s.objects << ",\n";
+		out << "      \"visibleObjects\": " << s.visibleObjects << ",\n";
+		out << "      \"deviceMemoryHighWaterBytes\": " << s.deviceMemoryHighWaterBytes << ",\n";
+		out << "      \"cpuWaitsPerFrame\": " << s.cpuWaitsPerFrame << ",\n";
+		out << "      \"cpuFrameMs\": ";
+		WritePercentiles( out, s.cpuFrameMs );
+		out << ",\n";
+		out << "      \"gpuPassMs\": {";
+		for( size_t p = 0; p < s.gpuPassMs.size(); ++p )
+		{
+			out << ( p == 0 ? "\n" : ",\n" ) << "        " << Quoted( s.gpuPassMs[p].first ) << ": ";
+			WritePercentiles( out, s.gpuPassMs[p].second );
+		}
+		out << ( s.gpuPassMs.empty() ? "}\n" : "\n      }\n" );
+		out << "    }" << ( i + 1 < scenes.size() ? ",\n" : "\n" );
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+// -------------------
+
+// --- JSON READER ---
+// only what the reports need: objects, arrays, strings, numbers, true / false / null
+// -------------------
+namespace
+{
+	class FlatJsonParser
+	{
+	public:
+		FlatJsonParser( const std::string& text, FlatJson& out ) : text( text ), out( out ) {}
+
+		void ParseDocument()
+		{
+			ParseValue( "" );
+			SkipWhitespace();
+			if( pos != text.size() )
+				Fail( "trailing characters" );
+		}
+
+	private:
+		void ParseValue( const std::string& path )
+		{
+			SkipWhitespace();
+			if( pos >= text.size() )
+				Fail( "unexpected end" );
+
+			const char c = text[pos];
+			if( c == '{' )
+				ParseObject( path );
+			else if( c == '[' )
+				ParseArray( path );
+			else if( c == '"' )
+				out.strings[path] = ParseString();
+			else if( Consume( "true" ) )
+				out.numbers[path] = 1.0;
+			else if( Consume( "false" ) )
+				out.numbers[path] = 0.0;
+			else if( Consume( "null" ) )
+				return;
+			else
+				out.numbers[path] = ParseNumber();
+		}
+
+		void ParseObject( const std::string& path )
+		{
+			Expect( '{' );
+			SkipWhitespace();
+			if( Peek( '}' ) )
+			{
+				++pos;
+				return;
+			}
+			while( true )
+			{
+				SkipWhitespace();
+				const std::string key = ParseString();
+				SkipWhitespace();
+				Expect( ':' );
+				ParseValue( Join( path, key ) );
+				SkipWhitespace();
+				if( Peek( ',' ) )
+				{
+					++pos;
+					continue;
+				}
+				Expect( '}' );
+				return;
+			}
+		}
+
+		void ParseArray( const std::string& path )
+		{
+			Expect( '[' );
+			SkipWhitespace();
+			if( Peek( ']' ) )
+			{
+				++pos;
+				return;
+			}
+			for( size_t index = 0;; ++index )
+			{
+				// parse into a scratch document first, the key depends on the element's "name"
+				FlatJson element;
+				FlatJsonParser inner( text, element );
+				inner.pos = pos;
+				inner.ParseValue( "" );
+				pos = inner.pos;
+
+				const auto name = element.strings.find( "name" );
+				const std::string elementPath = Join( path, name != element.strings.end() ? name->second : std::to_string( index ) );
+				for( const auto& n : element.numbers )
+					out.numbers[Join( elementPath, n.first )] = n.second;
+				for( const auto& s : element.strings )
+					out.strings[Join( elementPath, s.first )] = s.second;
+
+				SkipWhitespace();
+				if( Peek( ',' ) )
+				{
+					++pos;
+					continue;
+				}
+				Expect( ']' );
+				return;
+			}
+		}
+
+		std::string ParseString()
+		{
+			Expect( '"' );
+			std::string r;
+			while( pos < text.size() && text[pos] != '"' )
+			{
+				char c = text[pos++];
+				if( c == '\\' && pos < text.size() )
+				{
+					c = text[pos++];
+					switch( c )
+					{
+					case 'n': c = '\n'; break;
+					case 't': c = '\t'; break;
+					case 'r': c = '\r'; break;
+					case 'b': c = '\b'; break;
+					case 'f': c = '\f'; break;
+					case 'u': pos += 4; c = '?'; break;	// names in our reports are ASCII
+					default: break;
+					}
+				}
+				r += c;
+			}
+			Expect( '"' );
+			return r;
+		}
+
+		double ParseNumber()
+		{
+			const char* begin = text.c_str() + pos;
+			char* end = nullptr;
+			const double value = std::strtod( begin, &end );
+			if( end == begin )
+				Fail( "expected a value" );
+			pos += static_cast<size_t>( end - begin );
+			return value;
+		}
+
+		static std::string Join( const std::string& path, const std::string& key )
+		{
+			return path.empty() ? key : path + "." + key;
+		}
+
+		void SkipWhitespace()
+		{
+			while( pos < text.size() && std::isspace( static_cast<unsigned char>( text[pos] ) ) )
+				++pos;
+		}
+		bool Peek( char c ) const { return pos < text.size() && text[pos] == c; }
+		bool Consume( const char* word )
+		{
+			const size_t len = std::strlen( word );
+			if( text.compare( pos, len, word ) != 0 )
+				return false;
+			pos += len;
+			return true;
+		}
+		void Expect( char c )
+		{
+			if( !Peek( c ) )
+				Fail( std::string( "expected '" ) + c + "'" );
+			++pos;
+		}
+		[[noreturn]] void Fail( const std::string& what ) const
+		{
+			throw std::runtime_error( "Malformed JSON at offset " + std::to_string( pos ) + ": " + what );
+		}
+
+	private:
+		const std::string& text;
+		FlatJson& out;
+		size_t pos = 0;
+	};
+}
+
+FlatJson FlatJson::Parse( const std::string& text )
+{
+	FlatJson result;
+	FlatJsonParser( text, result ).ParseDocument();
+	return result;
+}
+
+FlatJson FlatJson::Load( const std::string& path )
+{
+	std::ifstream file( path );
+	if( !file )
+		throw std::runtime_error( "Failed to open " + path );
+	std::stringstream ss;
+	ss << file.rdbuf();
+	return Parse( ss.str() );
+}
+// -------------------
+
+static bool EndsWith( const std::string& s, const std::string& suffix )
+{
+	return s.size() >= suffix.size() && s.compare( s.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+// "scenes.cull_10k.cpuFrameMs.p99" -> "cull_10k", empty for keys outside a scene
+static std::string SceneOf( const std::string& key )
+{
+	static const std::string prefix = "scenes.";
+	if( key.compare( 0, prefix.size(), prefix ) != 0 )
+		return std::string();
+	return key.substr( prefix.size(), key.find( '.', prefix.size() ) - prefix.size() );
+}
+
+// Only the mean, p50 and p90 of a scene's times are gated. startupMs is a single cold start and the
+// max a single frame, both far too noisy, and a nearest rank p99 needs enough frames to not be the max.
+// report supplies the frame count, the current run or the baseline for keys the run lacks
+static bool IsGatedTime( const std::string& key, const FlatJson& report, const RegressionThresholds& thresholds )
+{
+	if( key.find( "Ms." ) == std::string::npos )
+		return false;
+	if( EndsWith( key, ".mean" ) || EndsWith( key, ".p50" ) || EndsWith( key, ".p90" ) )
+		return true;
+	if( !EndsWith( key, ".p99" ) )
+		return false;
+
+	const auto frames = report.numbers.find( "scenes." + SceneOf( key ) + ".frames" );
+	return frames != report.numbers.end() && frames->second >= thresholds.minSamplesForP99;
+}
+
+// the scenes run with fixed seeds, so these are exact and any difference means a changed or broken scene
+static bool MustMatch( const std::string& key )
+{
+	return EndsWith( key, ".visibleObjects" ) || EndsWith( key, ".seed" ) || EndsWith( key, ".frames" ) || EndsWith( key, ".objects" );
+}
+
+int CompareAgainstBaseline( const FlatJson& current, const FlatJson& baseline, const RegressionThresholds& thresholds,
+	const std::string& sceneFilter, std::ostream& log )
+{
+	const auto device = current.strings.find( "deviceName" );
+	const auto baselineDevice = baseline.strings.find( "deviceName" );
+	if( device != current.strings.end() && baselineDevice != baseline.strings.end() && device->second != baselineDevice->second )
+		log << "warning: baseline was recorded on \"" << baselineDevice->second << "\", comparing anyway\n";
+
+	// formatted locally, so the caller's stream keeps its flags and precision
+	std::ostringstream out;
+	out << std::fixed << std::setprecision( 3 );
+
+	int regressions = 0;
+	std::set<std::string> filteredScenes;
+	for( const auto& [key, base] : baseline.numbers )
+	{
+		const auto it = current.numbers.find( key );
+		if( it == current.numbers.end() )
+		{
+			const std::string scene = SceneOf( key );
+			if( !sceneFilter.empty() && !scene.empty() && scene != sceneFilter )
+			{
+				if( filteredScenes.insert( scene ).second )
+					out << "  skip  scenes." << scene << ": filtered out by --scene " << sceneFilter << "\n";
+				continue;
+			}
+			// only metrics that would be gated, a renamed metric or a device without timestamps would
+			// otherwise pass without being compared
+			if( !IsGatedTime( key, baseline, thresholds ) && !EndsWith( key, "Bytes" ) && !MustMatch( key ) )
+			{
+				out << "  note  " << key << ": missing from this run (baseline " << base << ")\n";
+				continue;
+			}
+			out << "  FAIL  " << key << ": missing from this run (baseline " << base << ")\n";
+			++regressions;
+			continue;
+		}
+		const double value = it->second;
+
+		const bool isTime = IsGatedTime( key, current, thresholds );
+		const bool isMemory = EndsWith( key, "Bytes" );
+
+		bool regressed = false;
+		if( MustMatch( key ) )
+			regressed = value != base;
+		else if( isTime )
+			regressed = value > base * ( 1.0 + thresholds.maxTimeRegression ) && value - base > thresholds.minDeltaMs;
+		else if( isMemory )
+			regressed = value > base * ( 1.0 + thresholds.maxMemoryRegression );
+		else if( value != base )
+		{
+			out << "  note  " << key << ": " << value << " (baseline " << base << ")\n";
+			continue;
+		}
+		else
+			continue;
+
+		const double change = base != 0.0 ? ( value - base ) / base * 100.0 : 0.0;
+		out << ( regressed ? "  FAIL  " : "  ok    " ) << key << ": " << value << " (baseline " << base << ", "
+			<< std::showpos << change << std::noshowpos << "%)\n";
+		regressions += regressed ? 1 : 0;
+	}
+	log << out.str();
+	return regressions;
+}
+
+uint64_t PeakHostMemoryBytes()
+{
+#if defined( _WIN32 )
+	PROCESS_MEMORY_COUNTERS counters{};
+	if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+		return static_cast<uint64_t>( counters.PeakWorkingSetSize );
+	return 0;
+#else
+	rusage usage{};
+	if( getrusage( RUSAGE_SELF, &usage ) != 0 )
+		return 0;
+#if defined( __APPLE__ )
+	return static_cast<uint64_t>( usage.ru_maxrss );	// already bytes
+#else
+	return static_cast<uint64_t>( usage.ru_maxrss ) * 1024u;
+#endif
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+
+struct Percentiles
+{
+public:
+	// nearest rank percentiles, all zero for an empty sample set
+	static Percentiles From( std::vector<double> samples );
+public:
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+struct SceneResult
+{
+	std::string name;
+	uint32_t seed = 0;
+	uint32_t frames = 0;
+	uint32_t objects = 0;
+	Percentiles cpuFrameMs;
+	std::vector<std::pair<std::string, Percentiles>> gpuPassMs;	// empty when the queue has no timestamps
+	uint64_t deviceMemoryHighWaterBytes = 0;
+	uint64_t visibleObjects = 0;	// summed over all measured frames, a cheap determinism check
+	double cpuWaitsPerFrame = 0.0;	// times the CPU blocked on the GPU, see TimelineSync
+};
+
+struct BenchmarkReport
+{
+public:
+	void WriteJson( std::ostream& out ) const;
+public:
+	std::string deviceName;
+	std::string simdLevel;
+	bool timelineSemaphores = false;
+	double startupMs = 0.0;
+	uint64_t peakHostMemoryBytes = 0;
+	std::vector<SceneResult> scenes;
+};
+
+struct RegressionThresholds
+{
+	double maxTimeRegression = 0.15;	// fraction over baseline allowed for *Ms metrics
+	double maxMemoryRegression = 0.10;	// fraction over baseline allowed for *Bytes metrics
+	double minDeltaMs = 0.05;			// absolute noise floor, smaller time differences never count
+	uint32_t minSamplesForP99 = 200;	// p99 of fewer frames is one of the two or three slowest, only reported
+};
+
+// JSON flattened to dotted paths, e.g. "scenes.cull_10k.cpuFrameMs.p99".
+// Array elements that carry a "name" string are keyed by it, others by index.
+struct FlatJson
+{
+public:
+	static FlatJson Parse( const std::string& text );	// throws std::runtime_error on malformed input
+	static FlatJson Load( const std::string& path );
+public:
+	std::map<std::string, double> numbers;
+	std::map<std::string, std::string> strings;
+};
+
+// Prints every compared metric to log and returns the number of regressions. A baseline metric the
+// current run lacks counts as one, unless its scene was left out on purpose: sceneFilter names the only
+// scene that ran, empty when all of them did
+int CompareAgainstBaseline( const FlatJson& current, const FlatJson& baseline, const RegressionThresholds& thresholds,
+	const std::string& sceneFilter, std::ostream& log );
+
+uint64_t PeakHostMemoryBytes();
\ No newline at end of file
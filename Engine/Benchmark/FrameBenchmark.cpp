@@ -0,0 +1,694 @@
+// Headless frame benchmark. Drives scripted scenes with fixed seeds and fixed frame counts on a
+// HeadlessContext ( lavapipe in CI ), writes the measurements as JSON and, given a baseline,
+// fails when a metric regressed past its threshold.
+//
+// usage: FrameBenchmark [--out results.json] [--baseline baseline.json] [--scene name]
+//                       [--max-time-regression 0.15] [--max-memory-regression 0.10] [--min-delta-ms 0.05]
+//                       [--min-p99-samples 200]
+//                       [--require-cpu-device] [--validation]
+//                       [--capture dir] [--capture-format raw|png|y4m] [--capture-threads n] [--capture-direct-io]
+//                       [--capture-drop] [--frames-in-flight n]
+// exit code: 0 ok, 1 regression against the baseline, 2 setup / usage error
+
+#include "../HeadlessContext.h"
+#include "../MathKernels.h"
+#include "../TimelineSync.h"
+#include "../DeletionQueue.h"
+#include "../VulkanHandle.h"
+#include "../FrameCapture.h"
+#include "BenchmarkReport.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <algorithm>
+#include <initializer_list>
+
+struct SceneScript
+{
+	const char* name;
+	uint32_t seed;
+	uint32_t warmupFrames;	// run but not measured, lets the driver finish lazy setup
+	uint32_t frameCount;
+	uint32_t objectCount;
+	uint32_t width;
+	uint32_t height;
+};
+
+// changing any of these invalidates stored baselines
+static const SceneScript sceneScripts[] = {
+	{ "clear_1080p", 1u, 10, 300, 0, 1920, 1080 },
+	{ "cull_10k", 2u, 10, 300, 10000, 1920, 1080 },
+	{ "cull_100k", 3u, 10, 120, 100000, 1920, 1080 },
+	{ "clear_4k", 4u, 5, 60, 1000, 3840, 2160 },
+};
+
+// Live device memory of one scene, counted through SceneMemory below
+struct MemoryCounter
+{
+	uint64_t bytes = 0;
+	uint64_t highWater = 0;
+};
+
+// Device memory that counts towards a MemoryCounter for as long as it is owned
+class SceneMemory
+{
+public:
+	SceneMemory() = default;
+	SceneMemory( MemoryCounter& counter, UniqueDeviceMemory memory, VkDeviceSize size )
+		: memory( std::move( memory ) ), size( size ), counter( &counter )
+	{
+		counter.bytes += size;
+		counter.highWater = std::max( counter.highWater, counter.bytes );
+	}
+	SceneMemory( SceneMemory&& other ) noexcept = default;
+	SceneMemory& operator=( SceneMemory&& other ) noexcept
+	{
+		if( this != &other )
+		{
+			Reset();
+			memory = std::move( other.memory );
+			size = other.size;
+			counter = other.counter;
+		}
+		return *this;
+	}
+	~SceneMemory() { Reset(); }
+
+	VkDeviceMemory Get() const { return memory.Get(); }
+
+	void Reset()
+	{
+		if( memory )
+			counter->bytes -= size;
+		memory.Reset();
+	}
+
+private:
+	UniqueDeviceMemory memory;
+	VkDeviceSize size = 0;
+	MemoryCounter* counter = nullptr;
+};
+
+class SceneRunner
+{
+public:
+	SceneRunner( HeadlessContext& context, const SceneScript& script ) : context( context ), script( script ) {}
+
+	// writes every measured frame to options.directory, has to be called before Init
+	void EnableCapture( const FrameCapture::Options& options );
+	// frames the CPU may run ahead of the GPU, 1 unless set before Init
+	void SetFramesInFlight( uint32_t count ) { framesInFlight = std::max( count, 1u ); }
+	FrameCapture::Stats CaptureStats() const { return capture.GetStats(); }
+
+	void Init();
+	SceneResult Run();
+	void CleanUp();
+
+private:
+	enum Pass { UploadPass, ClearPass, PassCount };
+
+	// what the CPU writes or records for one frame while earlier frames may still run on the GPU
+	struct FrameSlot
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		uint32_t firstQuery = 0;
+		UniqueBuffer stagingBuffer;
+		SceneMemory stagingBufferMemory;
+		float* stagingMapped = nullptr;
+		TimelinePoint done;
+		bool pending = false;
+		bool measured = false;
+	};
+
+	void GenerateObjects();
+	uint32_t UpdateAndCull( uint32_t frame, float* instances );
+	void RecordFrame( uint32_t frame, const FrameSlot& slot, uint32_t visibleCount, bool captureFrame );
+
+	SceneMemory Allocate( const VkMemoryRequirements& requirements, VkMemoryPropertyFlags memoryFlags, MemoryCounter& counter );
+	void CreateBuffer( VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags, MemoryCounter& counter,
+		UniqueBuffer& buffer, SceneMemory& memory );
+	void CreateColorImage();
+
+private:
+	HeadlessContext& context;
+	const SceneScript& script;
+
+	// objects, structure of arrays so the math kernels can batch them
+	std::vector<float> baseX, baseY, baseZ;
+	std::vector<float> worldX, worldY, worldZ;
+	std::vector<float> extentX, extentY, extentZ;
+	std::vector<uint8_t> visible;
+
+	// before the handles, which release into the deletion queue
+	TimelineSync sync;
+	uint32_t graphicsTimeline = 0;
+	DeletionQueue deletionQueue;
+	// only the scene's own memory, capture readback buffers and the staging copies of frames past the
+	// first stay out so runs with --capture or --frames-in-flight compare against the same baselines
+	MemoryCounter deviceMemory;
+	MemoryCounter extraFrameMemory;
+
+	UniqueCommandPool commandPool;
+	UniqueQueryPool queryPool;
+
+	UniqueImage colorImage;
+	SceneMemory colorImageMemory;
+	UniqueBuffer instanceBuffer;
+	SceneMemory instanceBufferMemory;
+
+	uint32_t framesInFlight = 1;
+	std::vector<FrameSlot> frames;
+
+	bool captureEnabled = false;
+	FrameCapture::Options captureOptions;
+	FrameCapture capture;
+};
+
+static constexpr VkDeviceSize instanceStride = sizeof( float ) * 4;
+
+void SceneRunner::Init()
+{
+	GenerateObjects();
+
+	sync.Init( context.device.Get(), context.timelineSemaphores );
+	graphicsTimeline = sync.RegisterQueue( context.graphicsQueue );
+	deletionQueue.Init( context.device.Get(), sync );
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = context.graphicsFamily;
+	VkCommandPool createdPool;
+	if( vkCreateCommandPool( context.device.Get(), &poolInfo, nullptr, &createdPool ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to create command pool" );
+	commandPool = UniqueCommandPool( deletionQueue, createdPool );
+
+	frames.resize( framesInFlight );
+	std::vector<VkCommandBuffer> commandBuffers( framesInFlight );
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = commandPool.Get();
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = framesInFlight;
+	if( vkAllocateCommandBuffers( context.device.Get(), &allocInfo, commandBuffers.data() ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to allocate command buffers" );
+	for( uint32_t i = 0; i < framesInFlight; ++i )
+	{
+		frames[i].commandBuffer = commandBuffers[i];
+		frames[i].firstQuery = i * PassCount * 2;
+	}
+
+	if( context.timestampValidBits > 0 )
+	{
+		VkQueryPoolCreateInfo queryInfo{};
+		queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryInfo.queryCount = PassCount * 2 * framesInFlight;
+		VkQueryPool createdQueryPool;
+		if( vkCreateQueryPool( context.device.Get(), &queryInfo, nullptr, &createdQueryPool ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to create timestamp query pool" );
+		queryPool = UniqueQueryPool( deletionQueue, createdQueryPool );
+	}
+
+	CreateColorImage();
+
+	const VkDeviceSize instanceBytes = std::max<VkDeviceSize>( script.objectCount, 1 ) * instanceStride;
+	CreateBuffer( instanceBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, deviceMemory, instanceBuffer, instanceBufferMemory );
+	for( FrameSlot& slot : frames )
+	{
+		CreateBuffer( instanceBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&slot == &frames[0] ? deviceMemory : extraFrameMemory, slot.stagingBuffer, slot.stagingBufferMemory );
+
+		void* mapped = nullptr;
+		if( vkMapMemory( context.device.Get(), slot.stagingBufferMemory.Get(), 0, VK_WHOLE_SIZE, 0, &mapped ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to map staging buffer" );
+		slot.stagingMapped = static_cast<float*>( mapped );
+	}
+
+	if( captureEnabled )
+		capture.Init( context.device.Get(), context.memoryProperties, sync, deletionQueue, { script.width, script.height },
+			VK_FORMAT_R8G8B8A8_UNORM, captureOptions );
+}
+
+void SceneRunner::EnableCapture( const FrameCapture::Options& options )
+{
+	captureEnabled = true;
+	captureOptions = options;
+}
+
+SceneResult SceneRunner::Run()
+{
+	using Clock = std::chrono::steady_clock;
+
+	SceneResult result;
+	result.name = script.name;
+	result.seed = script.seed;
+	result.frames = script.frameCount;
+	result.objects = script.objectCount;
+
+	const uint64_t timestampMask = context.timestampValidBits >= 64 ? ~0ull : ( 1ull << context.timestampValidBits ) - 1;
+	const double timestampToMs = static_cast<double>( context.properties.limits.timestampPeriod ) / 1.0e6;
+
+	std::vector<double> cpuFrameMs;
+	std::vector<double> gpuPassMs[PassCount];
+	uint64_t measuredCpuWaits = 0;
+
+	// waits for a frame and takes its timestamps, before its slot is used again
+	auto retire = [&]( FrameSlot& slot )
+	{
+		sync.Wait( slot.done );
+		slot.pending = false;
+		if( !queryPool || !slot.measured )
+			return;
+
+		uint64_t timestamps[PassCount * 2] = {};
+		vkGetQueryPoolResults( context.device.Get(), queryPool.Get(), slot.firstQuery, PassCount * 2, sizeof( timestamps ), timestamps,
+			sizeof( uint64_t ), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT );
+		for( int p = 0; p < PassCount; ++p )
+			gpuPassMs[p].push_back( ( ( timestamps[p * 2 + 1] - timestamps[p * 2] ) & timestampMask ) * timestampToMs );
+	};
+
+	TimelineSubmit submit;
+	submit.commandBuffers.push_back( VK_NULL_HANDLE );
+
+	for( uint32_t frame = 0; frame < script.warmupFrames + script.frameCount; ++frame )
+	{
+		FrameSlot& slot = frames[frame % framesInFlight];
+		const bool measured = frame >= script.warmupFrames;
+
+		const auto frameStart = Clock::now();
+		sync.BeginFrame();
+		const uint64_t waitsBefore = sync.Stats().totalCpuWaits;
+
+		const uint32_t visibleCount = UpdateAndCull( frame, slot.stagingMapped );
+		RecordFrame( frame, slot, visibleCount, captureEnabled && measured );
+
+		submit.commandBuffers[0] = slot.commandBuffer;
+		const TimelinePoint frameDone = sync.Submit( graphicsTimeline, submit );
+		slot.done = frameDone;
+		slot.pending = true;
+		slot.measured = measured;
+		if( captureEnabled )
+			capture.Submitted( frameDone );
+
+		// one frame in flight, the default, keeps every frame independent of the previous one, which is
+		// what makes the numbers comparable between runs. With more, only the oldest frame is waited for,
+		// the one whose slot comes next
+		FrameSlot& oldest = frames[( frame + 1 ) % framesInFlight];
+		if( oldest.pending )
+			retire( oldest );
+		if( captureEnabled )
+			capture.Poll();	// only hands the readback to the encoders, the frame never waits for the disk
+		deletionQueue.EndFrame( frameDone );
+		deletionQueue.Collect();
+		sync.CollectRetired();
+
+		const auto frameEnd = Clock::now();
+		if( !measured )
+			continue;
+
+		measuredCpuWaits += sync.Stats().totalCpuWaits - waitsBefore;
+
+		cpuFrameMs.push_back( std::chrono::duration<double, std::milli>( frameEnd - frameStart ).count() );
+		result.visibleObjects += visibleCount;
+	}
+	for( FrameSlot& slot : frames )
+		if( slot.pending )
+			retire( slot );
+
+	result.cpuFrameMs = Percentiles::From( cpuFrameMs );
+	if( queryPool )
+	{
+		result.gpuPassMs.push_back( { "upload", Percentiles::From( gpuPassMs[UploadPass] ) } );
+		result.gpuPassMs.push_back( { "clear", Percentiles::From( gpuPassMs[ClearPass] ) } );
+	}
+	result.deviceMemoryHighWaterBytes = deviceMemory.highWater;
+	result.cpuWaitsPerFrame = script.frameCount > 0 ? static_cast<double>( measuredCpuWaits ) / script.frameCount : 0.0;
+	return result;
+}
+
+void SceneRunner::CleanUp()
+{
+	// flushes the remaining frames to disk, before the sync goes idle
+	capture.CleanUp();
+	sync.WaitIdle();
+	for( FrameSlot& slot : frames )
+	{
+		if( slot.stagingMapped != nullptr )
+			vkUnmapMemory( context.device.Get(), slot.stagingBufferMemory.Get() );
+		slot.stagingMapped = nullptr;
+	}
+
+	// the handles go with the members, the deletion queue destroys them before the sync cleans up
+}
+
+void SceneRunner::GenerateObjects()
+{
+	std::mt19937 rng( script.seed );
+	std::uniform_real_distribution<float> position( -250.0f, 250.0f );
+	std::uniform_real_distribution<float> size( 0.25f, 3.0f );
+
+	const size_t count = script.objectCount;
+	for( auto* v : { &baseX, &baseY, &baseZ, &worldX, &worldY, &worldZ, &extentX, &extentY, &extentZ } )
+		v->resize( count );
+	visible.resize( count );
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		baseX[i] = position( rng );
+		baseY[i] = position( rng ) * 0.1f;
+		baseZ[i] = position( rng );
+		extentX[i] = size( rng );
+		extentY[i] = size( rng );
+		extentZ[i] = size( rng );
+	}
+}
+
+// CPU side of a frame: instance update, frustum culling and packing the survivors for upload
+uint32_t SceneRunner::UpdateAndCull( uint32_t frame, float* instances )
+{
+	const MathKernels& kernels = MathKernels::Active();
+	const size_t count = script.objectCount;
+	const float time = static_cast<float>( frame ) / 60.0f;
+
+	// the whole field slowly orbits the origin while the camera spins in place
+	const Mat4 orbit = Mat4::RotationY( time * 0.2f );
+	kernels.TransformPoints( orbit, { baseX.data(), baseY.data(), baseZ.data(), count }, { worldX.data(), worldY.data(), worldZ.data() } );
+
+	const Mat4 projection = Mat4::Perspective( 1.0472f, static_cast<float>( script.width ) / script.height, 0.1f, 500.0f );
+	Mat4 viewProjection;
+	kernels.Mat4Multiply( projection, Mat4::RotationY( -time * 0.5f ), viewProjection );
+	const Frustum frustum = Frustum::FromViewProjection( viewProjection );
+
+	const AabbsSoA boxes = { worldX.data(), worldY.data(), worldZ.data(), extentX.data(), extentY.data(), extentZ.data(), count };
+	const uint32_t visibleCount = static_cast<uint32_t>( kernels.CullAabbs( frustum, boxes, visible.data() ) );
+
+	float* dst = instances;
+	for( size_t i = 0; i < count; ++i )
+	{
+		if( !visible[i] )
+			continue;
+		dst[0] = worldX[i];
+		dst[1] = worldY[i];
+		dst[2] = worldZ[i];
+		dst[3] = std::max( extentX[i], std::max( extentY[i], extentZ[i] ) );
+		dst += 4;
+	}
+	return visibleCount;
+}
+
+void SceneRunner::RecordFrame( uint32_t frame, const FrameSlot& slot, uint32_t visibleCount, bool captureFrame )
+{
+	const VkCommandBuffer commandBuffer = slot.commandBuffer;
+	vkResetCommandBuffer( commandBuffer, 0 );
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if( vkBeginCommandBuffer( commandBuffer, &beginInfo ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to begin command buffer" );
+
+	const bool timestamps = static_cast<bool>( queryPool );
+	if( timestamps )
+		vkCmdResetQueryPool( commandBuffer, queryPool.Get(), slot.firstQuery, PassCount * 2 );
+
+	// the previous frame can still be running with more than one frame in flight, its transfers into
+	// the shared instance buffer and color image have to finish first
+	VkMemoryBarrier previousFrame{};
+	previousFrame.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	previousFrame.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	previousFrame.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &previousFrame, 0, nullptr, 0, nullptr );
+
+	// Upload pass
+	// -----------
+	if( timestamps )
+		vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool.Get(), slot.firstQuery + UploadPass * 2 );
+	if( visibleCount > 0 )
+	{
+		VkBufferCopy region{};
+		region.size = visibleCount * instanceStride;
+		vkCmdCopyBuffer( commandBuffer, slot.stagingBuffer.Get(), instanceBuffer.Get(), 1, &region );
+	}
+	if( timestamps )
+		vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, queryPool.Get(), slot.firstQuery + UploadPass * 2 + 1 );
+	// -----------
+
+	// Clear pass
+	// ----------
+	if( timestamps )
+		vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool.Get(), slot.firstQuery + ClearPass * 2 );
+
+	VkImageSubresourceRange range{};
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = 1;
+	range.baseArrayLayer = 0;
+	range.layerCount = 1;
+
+	// the whole image gets overwritten, so the old contents can be discarded every frame, but not before
+	// the previous frame's clear and readback are done with it
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = colorImage.Get();
+	barrier.subresourceRange = range;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier );
+
+	VkClearColorValue color{};
+	color.float32[0] = static_cast<float>( frame % 256 ) / 255.0f;
+	color.float32[1] = 0.2f;
+	color.float32[2] = 0.4f;
+	color.float32[3] = 1.0f;
+	vkCmdClearColorImage( commandBuffer, colorImage.Get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range );
+
+	if( timestamps )
+		vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, queryPool.Get(), slot.firstQuery + ClearPass * 2 + 1 );
+	// ----------
+
+	// outside the timed passes, the readback is not part of what the baselines measure
+	if( captureFrame )
+		capture.Record( commandBuffer, colorImage.Get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT );
+
+	if( vkEndCommandBuffer( commandBuffer ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to record command buffer" );
+}
+
+SceneMemory SceneRunner::Allocate( const VkMemoryRequirements& requirements, VkMemoryPropertyFlags memoryFlags, MemoryCounter& counter )
+{
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = context.FindMemoryType( requirements.memoryTypeBits, memoryFlags );
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	if( vkAllocateMemory( context.device.Get(), &allocInfo, nullptr, &memory ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to allocate device memory" );
+
+	return SceneMemory( counter, UniqueDeviceMemory( deletionQueue, memory ), requirements.size );
+}
+
+void SceneRunner::CreateBuffer( VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags, MemoryCounter& counter,
+	UniqueBuffer& buffer, SceneMemory& memory )
+{
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VkBuffer createdBuffer;
+	if( vkCreateBuffer( context.device.Get(), &bufferInfo, nullptr, &createdBuffer ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to create buffer" );
+	buffer = UniqueBuffer( deletionQueue, createdBuffer );
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements( context.device.Get(), buffer.Get(), &requirements );
+	memory = Allocate( requirements, memoryFlags, counter );
+	vkBindBufferMemory( context.device.Get(), buffer.Get(), memory.Get(), 0 );
+}
+
+void SceneRunner::CreateColorImage()
+{
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageInfo.extent = { script.width, script.height, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImage createdImage;
+	if( vkCreateImage( context.device.Get(), &imageInfo, nullptr, &createdImage ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to create color image" );
+	colorImage = UniqueImage( deletionQueue, createdImage );
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements( context.device.Get(), colorImage.Get(), &requirements );
+	colorImageMemory = Allocate( requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, deviceMemory );
+	vkBindImageMemory( context.device.Get(), colorImage.Get(), colorImageMemory.Get(), 0 );
+}
+
+struct Arguments
+{
+	std::string outPath = "frame_benchmark.json";
+	std::string baselinePath;
+	std::string scene;
+	RegressionThresholds thresholds;
+	HeadlessContext::Options contextOptions;
+	bool capture = false;
+	FrameCapture::Options captureOptions;
+	uint32_t framesInFlight = 0;	// 0 picks 1, or 2 with --capture so the readback ring actually runs ahead
+};
+
+static Arguments ParseArguments( int argc, char** argv )
+{
+	Arguments args;
+	for( int i = 1; i < argc; ++i )
+	{
+		const std::string arg = argv[i];
+		auto next = [&]() -> std::string
+		{
+			if( i + 1 >= argc )
+				throw std::runtime_error( "Missing value for " + arg );
+			return argv[++i];
+		};
+
+		if( arg == "--out" ) args.outPath = next();
+		else if( arg == "--baseline" ) args.baselinePath = next();
+		else if( arg == "--scene" ) args.scene = next();
+		else if( arg == "--max-time-regression" ) args.thresholds.maxTimeRegression = std::stod( next() );
+		else if( arg == "--max-memory-regression" ) args.thresholds.maxMemoryRegression = std::stod( next() );
+		else if( arg == "--min-delta-ms" ) args.thresholds.minDeltaMs = std::stod( next() );
+		else if( arg == "--min-p99-samples" ) args.thresholds.minSamplesForP99 = static_cast<uint32_t>( std::stoul( next() ) );
+		else if( arg == "--require-cpu-device" ) args.contextOptions.requireCpuDevice = true;
+		else if( arg == "--validation" ) args.contextOptions.enableValidation = true;
+		else if( arg == "--capture" )
+		{
+			args.capture = true;
+			args.captureOptions.directory = next();
+		}
+		else if( arg == "--capture-format" )
+		{
+			const std::string format = next();
+			if( !ParseCaptureFormat( format, args.captureOptions.format ) )
+				throw std::runtime_error( "Unknown capture format " + format );
+		}
+		else if( arg == "--capture-threads" ) args.captureOptions.encoderThreads = static_cast<uint32_t>( std::stoul( next() ) );
+		else if( arg == "--capture-direct-io" ) args.captureOptions.directIo = true;
+		else if( arg == "--capture-drop" ) args.captureOptions.dropWhenFull = true;
+		else if( arg == "--frames-in-flight" ) args.framesInFlight = static_cast<uint32_t>( std::stoul( next() ) );
+		else
+			throw std::runtime_error( "Unknown argument " + arg );
+	}
+	if( args.framesInFlight == 0 )
+		args.framesInFlight = args.capture ? 2 : 1;
+	return args;
+}
+
+int main( int argc, char** argv )
+{
+	try
+	{
+		const Arguments args = ParseArguments( argc, argv );
+
+		std::vector<const SceneScript*> scenes;
+		for( const SceneScript& s : sceneScripts )
+			if( args.scene.empty() || args.scene == s.name )
+				scenes.push_back( &s );
+		if( scenes.empty() )
+			throw std::runtime_error( "Unknown scene " + args.scene );
+
+		BenchmarkReport report;
+
+		HeadlessContext context;
+		const auto startupBegin = std::chrono::steady_clock::now();
+		context.Init( args.contextOptions );
+		report.startupMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startupBegin ).count();
+		report.deviceName = context.properties.deviceName;
+		report.simdLevel = ToString( MathKernels::Active().level );
+		report.timelineSemaphores = context.timelineSemaphores;
+
+		std::cout << "device: " << report.deviceName << ", math: " << report.simdLevel
+			<< ", sync: " << ( report.timelineSemaphores ? "timeline semaphores" : "fences" )
+			<< ", startup: " << report.startupMs << " ms, frames in flight: " << args.framesInFlight << std::endl;
+
+		for( const SceneScript* script : scenes )
+		{
+			SceneRunner runner( context, *script );
+			runner.SetFramesInFlight( args.framesInFlight );
+			if( args.capture )
+			{
+				FrameCapture::Options captureOptions = args.captureOptions;
+				captureOptions.directory += std::string( "/" ) + script->name;
+				runner.EnableCapture( captureOptions );
+			}
+			runner.Init();
+			report.scenes.push_back( runner.Run() );
+			runner.CleanUp();
+
+			const SceneResult& r = report.scenes.back();
+			std::cout << "  " << r.name << ": cpu p50 " << r.cpuFrameMs.p50 << " ms, p99 " << r.cpuFrameMs.p99 << " ms"
+				<< ", cpu waits/frame " << r.cpuWaitsPerFrame;
+			for( const auto& pass : r.gpuPassMs )
+				std::cout << ", gpu " << pass.first << " p50 " << pass.second.p50 << " ms";
+			std::cout << std::endl;
+
+			// capture numbers stay out of the JSON, baselines are recorded without capture
+			if( args.capture )
+			{
+				const FrameCapture::Stats c = runner.CaptureStats();
+				std::cout << "    capture " << ToString( args.captureOptions.format ) << ": " << c.framesWritten << "/" << c.framesCaptured
+					<< " frames, " << c.FramesPerSecond() << " fps, " << c.MegabytesPerSecond() << " MB/s"
+					<< ", max readbacks in flight " << c.maxReadbacksInFlight << ", max encode queue " << c.maxEncodeQueueDepth
+					<< ", stalls " << c.cpuWaits << ", dropped " << c.framesDropped << std::endl;
+			}
+		}
+
+		report.peakHostMemoryBytes = PeakHostMemoryBytes();
+
+		std::ofstream out( args.outPath );
+		if( !out )
+			throw std::runtime_error( "Failed to open " + args.outPath );
+		report.WriteJson( out );
+		out.close();
+		std::cout << "results written to " << args.outPath << std::endl;
+
+		if( args.baselinePath.empty() )
+			return EXIT_SUCCESS;
+
+		// compare through the written file, so current and baseline go through the same parser
+		const FlatJson current = FlatJson::Load( args.outPath );
+		const FlatJson baseline = FlatJson::Load( args.baselinePath );
+		const int regressions = CompareAgainstBaseline( current, baseline, args.thresholds, args.scene, std::cout );
+		if( regressions > 0 )
+		{
+			std::cout << regressions << " metric(s) regressed or missing against " << args.baselinePath << std::endl;
+			return 1;
+		}
+		std::cout << "no regressions against " << args.baselinePath << std::endl;
+		return EXIT_SUCCESS;
+	}
+	catch( const std::exception& e )
+	{
+		std::cerr << e.what() << std::endl;
+		return 2;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,308 @@
+// Micro benchmark for the math kernels. Every SIMD table the CPU supports is first checked
+// against the scalar reference, then timed on the same data.
+//
+// usage: MathBenchmark [objectCount] [iterations]
+// exits with EXIT_FAILURE when any kernel disagrees with the scalar reference.
+
+#include "../MathKernels.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <cstdlib>
+#include <limits>
+#include <iterator>
+#include <initializer_list>
+
+struct BenchData
+{
+	explicit BenchData( size_t count, uint32_t seed )
+	{
+		std::mt19937 rng( seed );
+		std::uniform_real_distribution<float> pos( -200.0f, 200.0f );
+		std::uniform_real_distribution<float> size( 0.1f, 4.0f );
+		std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+
+		for( auto* v : { &x, &y, &z, &radius, &extentX, &extentY, &extentZ } )
+			v->resize( count );
+		for( size_t i = 0; i < count; ++i )
+		{
+			x[i] = pos( rng );
+			y[i] = pos( rng );
+			z[i] = pos( rng );
+			radius[i] = size( rng );
+			extentX[i] = size( rng );
+			extentY[i] = size( rng );
+			extentZ[i] = size( rng );
+		}
+
+		for( Mat4& m : matrices )
+		{
+			// random but well conditioned: a dominant diagonal plus noise
+			for( float& e : m.m )
+				e = unit( rng );
+			for( int i = 0; i < 4; ++i )
+				m( i, i ) += 4.0f;
+		}
+
+		const Mat4 proj = Mat4::Perspective( 1.0472f, 16.0f / 9.0f, 0.1f, 500.0f );
+		const Mat4 view = Mat4::RotationY( 0.3f );
+		MathKernels::Scalar().Mat4Multiply( proj, view, viewProj );
+		frustum = Frustum::FromViewProjection( viewProj );
+	}
+
+	PositionsSoA Positions() const { return { x.data(), y.data(), z.data(), x.size() }; }
+	SpheresSoA Spheres() const { return { x.data(), y.data(), z.data(), radius.data(), x.size() }; }
+	AabbsSoA Aabbs() const { return { x.data(), y.data(), z.data(), extentX.data(), extentY.data(), extentZ.data(), x.size() }; }
+
+public:
+	std::vector<float> x, y, z, radius, extentX, extentY, extentZ;
+	Mat4 matrices[64];
+	Mat4 viewProj;
+	Frustum frustum;
+};
+
+static bool NearlyEqual( float a, float b, float tolerance )
+{
+	return std::abs( a - b ) <= tolerance * std::max( 1.0f, std::max( std::abs( a ), std::abs( b ) ) );
+}
+
+// row of m applied to ( x, y, z, 1 ). The tolerance scales with the summed terms and not the result,
+// which can be tiny after cancellation, and FMA rounds those cancelled low bits differently
+static bool TransformedNearlyEqual( const Mat4& m, int row, float x, float y, float z, float expected, float actual, float tolerance )
+{
+	const float magnitude = std::abs( m( row, 0 ) * x ) + std::abs( m( row, 1 ) * y ) + std::abs( m( row, 2 ) * z ) + std::abs( m( row, 3 ) );
+	return std::abs( expected - actual ) <= tolerance * std::max( 1.0f, magnitude );
+}
+
+// the SIMD kernels sum in a different order, so an object sitting right on a plane may flip.
+// Those are the only disagreements accepted.
+static float SmallestPlaneMargin( const Frustum& frustum, float x, float y, float z, float sphereRadius, float ex, float ey, float ez )
+{
+	float margin = std::numeric_limits<float>::max();
+	for( const Plane& p : frustum.planes )
+	{
+		const float dist = p.normal.x * x + p.normal.y * y + p.normal.z * z + p.d;
+		const float radius = sphereRadius + std::abs( p.normal.x ) * ex + std::abs( p.normal.y ) * ey + std::abs( p.normal.z ) * ez;
+		margin = std::min( margin, std::abs( dist + radius ) );
+	}
+	return margin;
+}
+
+static bool Verify( const MathKernels& kernels, const BenchData& data )
+{
+	const MathKernels& reference = MathKernels::Scalar();
+	bool ok = true;
+	auto fail = [&ok, &kernels]( const std::string& what )
+	{
+		std::cerr << "  [" << ToString( kernels.level ) << "] mismatch: " << what << std::endl;
+		ok = false;
+	};
+
+	// Mat4Multiply
+	for( size_t i = 0; i + 1 < std::size( data.matrices ); ++i )
+	{
+		Mat4 expected, actual;
+		reference.Mat4Multiply( data.matrices[i], data.matrices[i + 1], expected );
+		kernels.Mat4Multiply( data.matrices[i], data.matrices[i + 1], actual );
+		for( int e = 0; e < 16; ++e )
+			if( !NearlyEqual( expected.m[e], actual.m[e], 1e-5f ) )
+			{
+				fail( "Mat4Multiply" );
+				break;
+			}
+	}
+
+	// Mat4Inverse, M * inverse( M ) has to be the identity
+	for( const Mat4& m : data.matrices )
+	{
+		Mat4 inv, product;
+		if( !kernels.Mat4Inverse( m, inv ) )
+		{
+			fail( "Mat4Inverse reported a regular matrix as singular" );
+			break;
+		}
+		reference.Mat4Multiply( m, inv, product );
+		const Mat4 identity = Mat4::Identity();
+		for( int e = 0; e < 16; ++e )
+			if( std::abs( product.m[e] - identity.m[e] ) > 1e-4f )
+			{
+				fail( "Mat4Inverse" );
+				break;
+			}
+	}
+	Mat4 singular = Mat4::Identity();
+	singular.m[10] = 0.0f;
+	Mat4 unused;
+	if( kernels.Mat4Inverse( singular, unused ) )
+		fail( "Mat4Inverse accepted a singular matrix" );
+
+	// TransformPoints, odd count so the scalar tail gets exercised as well
+	const size_t count = data.x.size() - ( data.x.size() > 3 ? 3 : 0 );
+	PositionsSoA in = data.Positions();
+	in.count = count;
+	std::vector<float> ex( count ), ey( count ), ez( count ), ax( count ), ay( count ), az( count );
+	reference.TransformPoints( data.matrices[0], in, { ex.data(), ey.data(), ez.data() } );
+	kernels.TransformPoints( data.matrices[0], in, { ax.data(), ay.data(), az.data() } );
+	const Mat4& transform = data.matrices[0];
+	for( size_t i = 0; i < count; ++i )
+		if( !TransformedNearlyEqual( transform, 0, in.x[i], in.y[i], in.z[i], ex[i], ax[i], 1e-5f )
+			|| !TransformedNearlyEqual( transform, 1, in.x[i], in.y[i], in.z[i], ey[i], ay[i], 1e-5f )
+			|| !TransformedNearlyEqual( transform, 2, in.x[i], in.y[i], in.z[i], ez[i], az[i], 1e-5f ) )
+		{
+			fail( "TransformPoints at " + std::to_string( i ) );
+			break;
+		}
+
+	// CullSpheres / CullAabbs
+	std::vector<uint8_t> expected( count ), actual( count );
+	SpheresSoA spheres = data.Spheres();
+	spheres.count = count;
+	reference.CullSpheres( data.frustum, spheres, expected.data() );
+	const size_t sphereCount = kernels.CullSpheres( data.frustum, spheres, actual.data() );
+	if( sphereCount != static_cast<size_t>( std::count( actual.begin(), actual.end(), 1 ) ) )
+		fail( "CullSpheres visible count" );
+	for( size_t i = 0; i < count; ++i )
+		if( expected[i] != actual[i] && SmallestPlaneMargin( data.frustum, data.x[i], data.y[i], data.z[i], data.radius[i], 0.0f, 0.0f, 0.0f ) > 1e-3f )
+		{
+			fail( "CullSpheres at " + std::to_string( i ) );
+			break;
+		}
+
+	AabbsSoA boxes = data.Aabbs();
+	boxes.count = count;
+	reference.CullAabbs( data.frustum, boxes, expected.data() );
+	const size_t boxCount = kernels.CullAabbs( data.frustum, boxes, actual.data() );
+	if( boxCount != static_cast<size_t>( std::count( actual.begin(), actual.end(), 1 ) ) )
+		fail( "CullAabbs visible count" );
+	for( size_t i = 0; i < count; ++i )
+		if( expected[i] != actual[i] && SmallestPlaneMargin( data.frustum, data.x[i], data.y[i], data.z[i], 0.0f, data.extentX[i], data.extentY[i], data.extentZ[i] ) > 1e-3f )
+		{
+			fail( "CullAabbs at " + std::to_string( i ) );
+			break;
+		}
+
+	return ok;
+}
+
+// median of several timed runs, in nanoseconds per call of fn
+static double TimeNs( int iterations, const std::function<void()>& fn )
+{
+	constexpr int runs = 7;
+	std::vector<double> samples;
+	fn(); // warm up
+	for( int r = 0; r < runs; ++r )
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for( int i = 0; i < iterations; ++i )
+			fn();
+		const auto end = std::chrono::steady_clock::now();
+		samples.push_back( std::chrono::duration<double, std::nano>( end - start ).count() / iterations );
+	}
+	std::sort( samples.begin(), samples.end() );
+	return samples[runs / 2];
+}
+
+struct KernelTimes
+{
+	double multiply, inverse, transform, cullSpheres, cullAabbs;
+};
+
+static KernelTimes Measure( const MathKernels& kernels, const BenchData& data, int iterations )
+{
+	volatile float sink = 0.0f;
+	KernelTimes t{};
+
+	// the matrix kernels are too short for a single call to be timed, run them over the whole set
+	Mat4 product;
+	t.multiply = TimeNs( iterations, [&]()
+		{
+			for( const Mat4& m : data.matrices )
+				kernels.Mat4Multiply( data.viewProj, m, product );
+			sink = sink + product.m[0];
+		} ) / std::size( data.matrices );
+
+	Mat4 inv;
+	t.inverse = TimeNs( iterations, [&]()
+		{
+			for( const Mat4& m : data.matrices )
+				kernels.Mat4Inverse( m, inv );
+			sink = sink + inv.m[0];
+		} ) / std::size( data.matrices );
+
+	const size_t count = data.x.size();
+	std::vector<float> ox( count ), oy( count ), oz( count );
+	const int batchIterations = std::max( 1, iterations / 64 );
+	t.transform = TimeNs( batchIterations, [&]()
+		{
+			kernels.TransformPoints( data.matrices[0], data.Positions(), { ox.data(), oy.data(), oz.data() } );
+			sink = sink + ox[0];
+		} );
+
+	std::vector<uint8_t> visible( count );
+	t.cullSpheres = TimeNs( batchIterations, [&]()
+		{
+			sink = sink + static_cast<float>( kernels.CullSpheres( data.frustum, data.Spheres(), visible.data() ) );
+		} );
+	t.cullAabbs = TimeNs( batchIterations, [&]()
+		{
+			sink = sink + static_cast<float>( kernels.CullAabbs( data.frustum, data.Aabbs(), visible.data() ) );
+		} );
+
+	return t;
+}
+
+int main( int argc, char** argv )
+{
+	const size_t objectCount = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 16384;
+	const int iterations = argc > 2 ? std::atoi( argv[2] ) : 2000;
+	if( objectCount == 0 || iterations <= 0 )
+	{
+		std::cerr << "usage: MathBenchmark [objectCount] [iterations]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const BenchData data( objectCount, 1234u );
+	std::cout << "objects: " << objectCount << ", iterations: " << iterations
+		<< ", active kernels: " << ToString( MathKernels::Active().level ) << std::endl;
+
+	bool allOk = true;
+	KernelTimes scalar{};
+	for( SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON } )
+	{
+		const MathKernels* kernels = MathKernels::ForLevel( level );
+		if( kernels == nullptr )
+			continue;
+
+		if( !Verify( *kernels, data ) )
+		{
+			allOk = false;
+			continue;
+		}
+
+		const KernelTimes t = Measure( *kernels, data, iterations );
+		if( level == SimdLevel::Scalar )
+			scalar = t;
+
+		auto row = [&]( const char* name, double ns, double reference, size_t perCall )
+		{
+			std::cout << "  " << std::left << std::setw( 16 ) << name << std::right << std::fixed
+				<< std::setw( 12 ) << std::setprecision( 2 ) << ns << " ns/call"
+				<< std::setw( 10 ) << std::setprecision( 3 ) << ns / perCall << " ns/item"
+				<< std::setw( 8 ) << std::setprecision( 2 ) << reference / ns << "x" << std::endl;
+		};
+		std::cout << ToString( level ) << std::endl;
+		row( "Mat4Multiply", t.multiply, scalar.multiply, 1 );
+		row( "Mat4Inverse", t.inverse, scalar.inverse, 1 );
+		row( "TransformPoints", t.transform, scalar.transform, objectCount );
+		row( "CullSpheres", t.cullSpheres, scalar.cullSpheres, objectCount );
+		row( "CullAabbs", t.cullAabbs, scalar.cullAabbs, objectCount );
+	}
+
+	return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
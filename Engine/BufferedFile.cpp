@@ -0,0 +1,172 @@
+#include "BufferedFile.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+
+#if defined( __linux__ )
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#elif defined( _WIN32 )
+#include <malloc.h>
+#endif
+
+static uint8_t* AllocateAligned( size_t size )
+{
+#if defined( _WIN32 )
+	return static_cast<uint8_t*>( _aligned_malloc( size, BufferedFile::Alignment ) );
+#else
+	return static_cast<uint8_t*>( std::aligned_alloc( BufferedFile::Alignment, size ) );
+#endif
+}
+
+BufferedFile::~BufferedFile()
+{
+	try
+	{
+		Close();
+	}
+	catch( const std::exception& )
+	{
+		// errors only surface through an explicit Close()
+	}
+	FreeBuffer();
+}
+
+void BufferedFile::Open( const std::string& path, size_t bufferSize, bool direct )
+{
+	Close();
+
+	this->path = path;
+	capacity = ( std::max<size_t>( bufferSize, Alignment ) + Alignment - 1 ) / Alignment * Alignment;
+	used = 0;
+	bytesWritten = 0;
+	FreeBuffer();
+	buffer = AllocateAligned( capacity );
+	if( buffer == nullptr )
+		throw std::runtime_error( "Failed to allocate write buffer for " + path );
+
+#if defined( __linux__ )
+	this->direct = false;
+	if( direct )
+	{
+		fd = ::open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644 );
+		this->direct = fd >= 0;
+	}
+	if( fd < 0 )
+		fd = ::open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 )
+		throw std::runtime_error( "Failed to open " + path + ": " + std::strerror( errno ) );
+#else
+	( void )direct;
+	this->direct = false;
+	file = std::fopen( path.c_str(), "wb" );
+	if( file == nullptr )
+		throw std::runtime_error( "Failed to open " + path );
+	std::setvbuf( file, nullptr, _IONBF, 0 );	// already buffered here
+#endif
+}
+
+bool BufferedFile::IsOpen() const
+{
+#if defined( __linux__ )
+	return fd >= 0;
+#else
+	return file != nullptr;
+#endif
+}
+
+void BufferedFile::Write( const void* data, size_t size )
+{
+	const uint8_t* src = static_cast<const uint8_t*>( data );
+
+	// large writes skip the copy when nothing is buffered, O_DIRECT needs every write aligned though
+	if( !direct && used == 0 && size >= capacity )
+	{
+		WriteOut( src, size );
+		return;
+	}
+
+	while( size > 0 )
+	{
+		const size_t chunk = std::min( size, capacity - used );
+		std::memcpy( buffer + used, src, chunk );
+		used += chunk;
+		src += chunk;
+		size -= chunk;
+
+		if( used == capacity )
+		{
+			WriteOut( buffer, used );
+			used = 0;
+		}
+	}
+}
+
+void BufferedFile::Close()
+{
+	if( !IsOpen() )
+		return;
+
+#if defined( __linux__ )
+	if( used > 0 )
+	{
+		// the tail is not a whole block, O_DIRECT would reject it
+		if( direct )
+			::fcntl( fd, F_SETFL, ::fcntl( fd, F_GETFL ) & ~O_DIRECT );
+		direct = false;
+		WriteOut( buffer, used );
+		used = 0;
+	}
+	const int result = ::close( fd );
+	fd = -1;
+	if( result != 0 )
+		throw std::runtime_error( "Failed to close " + path + ": " + std::strerror( errno ) );
+#else
+	if( used > 0 )
+	{
+		WriteOut( buffer, used );
+		used = 0;
+	}
+	const int result = std::fclose( file );
+	file = nullptr;
+	if( result != 0 )
+		throw std::runtime_error( "Failed to close " + path );
+#endif
+}
+
+void BufferedFile::WriteOut( const uint8_t* data, size_t size )
+{
+#if defined( __linux__ )
+	while( size > 0 )
+	{
+		const ssize_t written = ::write( fd, data, size );
+		if( written < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			throw std::runtime_error( "Failed to write " + path + ": " + std::strerror( errno ) );
+		}
+		data += written;
+		size -= static_cast<size_t>( written );
+		bytesWritten += static_cast<uint64_t>( written );
+	}
+#else
+	if( std::fwrite( data, 1, size, file ) != size )
+		throw std::runtime_error( "Failed to write " + path );
+	bytesWritten += size;
+#endif
+}
+
+void BufferedFile::FreeBuffer()
+{
+#if defined( _WIN32 )
+	_aligned_free( buffer );
+#else
+	std::free( buffer );
+#endif
+	buffer = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <cstdio>
+
+// Sequential file writer with one large aligned buffer, only ever writes whole buffers until Close.
+// With direct set, Linux opens the file with O_DIRECT so big captures bypass the page cache; other
+// platforms, or filesystems that refuse O_DIRECT ( tmpfs ), get a plain buffered write instead.
+class BufferedFile
+{
+public:
+	static constexpr size_t Alignment = 4096;
+
+public:
+	BufferedFile() = default;
+	BufferedFile( const BufferedFile& ) = delete;
+	BufferedFile& operator=( const BufferedFile& ) = delete;
+	~BufferedFile();
+
+	// bufferSize is rounded up to Alignment
+	void Open( const std::string& path, size_t bufferSize, bool direct );
+	void Write( const void* data, size_t size );
+	// writes the tail and closes, throws std::runtime_error on I/O errors like Write
+	void Close();
+
+	bool IsOpen() const;
+	bool IsDirect() const { return direct; }
+	uint64_t BytesWritten() const { return bytesWritten; }
+
+private:
+	void WriteOut( const uint8_t* data, size_t size );
+	void FreeBuffer();
+
+private:
+	std::string path;
+#if defined( __linux__ )
+	int fd = -1;
+#else
+	std::FILE* file = nullptr;
+#endif
+	uint8_t* buffer = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+	bool direct = false;
+	uint64_t bytesWritten = 0;
+};
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include "CaptureEncoder.h"
+
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+
+const char* ToString( CaptureFormat format )
+{
+	switch( format )
+	{
+	case CaptureFormat::Raw: return "raw";
+	case CaptureFormat::Png: return "png";
+	case CaptureFormat::Y4m: return "y4m";
+	}
+	return "unknown";
+}
+
+bool ParseCaptureFormat( const std::string& name, CaptureFormat& format )
+{
+	for( CaptureFormat f : { CaptureFormat::Raw, CaptureFormat::Png, CaptureFormat::Y4m } )
+	{
+		if( name == ToString( f ) )
+		{
+			format = f;
+			return true;
+		}
+	}
+	return false;
+}
+
+// --- PNG ---
+// -----------
+// slice-by-8: table k advances a byte through k further zero bytes, so eight bytes fold in with one step
+// ( SSE4.2 crc32 computes CRC-32C, not the polynomial PNG uses )
+using Crc32Tables = uint32_t[8][256];
+static const Crc32Tables& Crc32Table()
+{
+	static const Crc32Tables& table = []() -> const Crc32Tables&
+	{
+		static Crc32Tables t;
+		for( uint32_t n = 0; n < 256; ++n )
+		{
+			uint32_t c = n;
+			for( int k = 0; k < 8; ++k )
+				c = ( c & 1 ) ? 0xEDB88320u ^ ( c >> 1 ) : c >> 1;
+			t[0][n] = c;
+		}
+		for( uint32_t n = 0; n < 256; ++n )
+			for( int k = 1; k < 8; ++k )
+				t[k][n] = t[0][t[k - 1][n] & 0xFF] ^ ( t[k - 1][n] >> 8 );
+		return t;
+	}();
+	return table;
+}
+
+static uint32_t Crc32( uint32_t crc, const uint8_t* data, size_t size )
+{
+	const Crc32Tables& t = Crc32Table();
+	crc = ~crc;
+	for( ; size >= 8; data += 8, size -= 8 )
+	{
+		const uint32_t lo = crc ^ ( uint32_t( data[0] ) | uint32_t( data[1] ) << 8 | uint32_t( data[2] ) << 16 | uint32_t( data[3] ) << 24 );
+		const uint32_t hi = uint32_t( data[4] ) | uint32_t( data[5] ) << 8 | uint32_t( data[6] ) << 16 | uint32_t( data[7] ) << 24;
+		crc = t[7][lo & 0xFF] ^ t[6][( lo >> 8 ) & 0xFF] ^ t[5][( lo >> 16 ) & 0xFF] ^ t[4][lo >> 24] ^
+			t[3][hi & 0xFF] ^ t[2][( hi >> 8 ) & 0xFF] ^ t[1][( hi >> 16 ) & 0xFF] ^ t[0][hi >> 24];
+	}
+	for( ; size > 0; ++data, --size )
+		crc = t[0][( crc ^ *data ) & 0xFF] ^ ( crc >> 8 );
+	return ~crc;
+}
+
+// adler32 with the modulo deferred to every 5552 bytes, the most before b can overflow 32 bits.
+// Whole 16-byte blocks go into per-lane sums that are folded into a and b once per run: lane j holds
+// sum[j] of its bytes and before[j] of the lane sums ahead of each block, so a byte in block k of K
+// counts 16 * ( K - 1 - k ) + 16 - j times in b
+static void Adler32( uint32_t& a, uint32_t& b, const uint8_t* data, size_t size )
+{
+	while( size > 0 )
+	{
+		const size_t n = std::min<size_t>( size, 5552 );
+		const size_t blocks = n / 16;
+		uint32_t sum[16] = {}, before[16] = {};
+		for( size_t k = 0; k < blocks; ++k, data += 16 )
+			for( int j = 0; j < 16; ++j )
+			{
+				before[j] += sum[j];
+				sum[j] += data[j];
+			}
+		uint64_t weighted = uint64_t( blocks ) * 16 * a;
+		for( int j = 0; j < 16; ++j )
+		{
+			weighted += uint64_t( before[j] ) * 16 + uint64_t( sum[j] ) * ( 16 - j );
+			a += sum[j];
+		}
+		b = uint32_t( ( b + weighted ) % 65521 );
+		for( size_t i = blocks * 16; i < n; ++i, ++data )
+		{
+			a += *data;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+		size -= n;
+	}
+}
+
+static void PutU32BigEndian( std::vector<uint8_t>& out, uint32_t v )
+{
+	const uint8_t bytes[4] = { uint8_t( v >> 24 ), uint8_t( v >> 16 ), uint8_t( v >> 8 ), uint8_t( v ) };
+	out.insert( out.end(), bytes, bytes + 4 );
+}
+
+static void PutChunk( std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t size )
+{
+	PutU32BigEndian( out, static_cast<uint32_t>( size ) );
+	const size_t typeOffset = out.size();
+	out.insert( out.end(), type, type + 4 );
+	if( size > 0 )
+		out.insert( out.end(), data, data + size );
+	PutU32BigEndian( out, Crc32( 0, out.data() + typeOffset, size + 4 ) );
+}
+
+void CaptureEncoder::EncodePng( const CaptureImage& image, std::vector<uint8_t>& out )
+{
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	out.clear();
+	out.insert( out.end(), signature, signature + 8 );
+
+	uint8_t header[13] = {};
+	for( int i = 0; i < 4; ++i )
+	{
+		header[i] = uint8_t( image.width >> ( 24 - i * 8 ) );
+		header[4 + i] = uint8_t( image.height >> ( 24 - i * 8 ) );
+	}
+	header[8] = 8;	// bit depth
+	header[9] = 6;	// RGBA
+	PutChunk( out, "IHDR", header, sizeof( header ) );
+
+	// IDAT is built in place: length and type first, the zlib stream, then length and CRC patched in
+	const size_t rowBytes = size_t( image.width ) * 4;
+	const size_t rawBytes = ( rowBytes + 1 ) * image.height;
+	const size_t blockCount = std::max<size_t>( 1, ( rawBytes + 65534 ) / 65535 );
+	const size_t zlibBytes = 2 + blockCount * 5 + rawBytes + 4;
+
+	const size_t chunkOffset = out.size();
+	out.resize( chunkOffset + 8 + zlibBytes + 4 );
+	uint8_t* dst = out.data() + chunkOffset + 8;
+	std::memcpy( out.data() + chunkOffset + 4, "IDAT", 4 );
+
+	// the CRC covers type and data and follows the writes row by row, while the bytes are still in cache
+	uint32_t crc = 0;
+	const uint8_t* crcFrom = out.data() + chunkOffset + 4;
+
+	*dst++ = 0x78;	// deflate, 32K window
+	*dst++ = 0x01;	// no compression level hint, header checksum ok
+
+	uint32_t adlerA = 1, adlerB = 0;
+	size_t blockRemaining = 0;
+	size_t rawRemaining = rawBytes;
+	auto emit = [&]( const uint8_t* src, size_t size )
+	{
+		while( size > 0 )
+		{
+			if( blockRemaining == 0 )
+			{
+				const size_t len = std::min<size_t>( rawRemaining, 65535 );
+				*dst++ = len == rawRemaining ? 1 : 0;	// BFINAL on the last block, BTYPE 00 stored
+				*dst++ = uint8_t( len );
+				*dst++ = uint8_t( len >> 8 );
+				*dst++ = uint8_t( ~len );
+				*dst++ = uint8_t( ~len >> 8 );
+				blockRemaining = len;
+			}
+			const size_t n = std::min( size, blockRemaining );
+			std::memcpy( dst, src, n );
+
+			Adler32( adlerA, adlerB, dst, n );
+
+			dst += n;
+			src += n;
+			size -= n;
+			blockRemaining -= n;
+			rawRemaining -= n;
+		}
+	};
+
+	// RGBA rows go straight from the image, BGRA is swizzled into a scratch row first
+	static const uint8_t filterNone = 0;
+	std::vector<uint8_t> row( image.bgra ? rowBytes : 0 );
+	for( uint32_t y = 0; y < image.height; ++y )
+	{
+		const uint8_t* src = image.pixels + size_t( y ) * rowBytes;
+		if( image.bgra )
+		{
+			uint8_t* p = row.data();
+			for( uint32_t x = 0; x < image.width; ++x, src += 4, p += 4 )
+			{
+				p[0] = src[2];
+				p[1] = src[1];
+				p[2] = src[0];
+				p[3] = src[3];
+			}
+			src = row.data();
+		}
+		emit( &filterNone, 1 );
+		emit( src, rowBytes );
+		crc = Crc32( crc, crcFrom, size_t( dst - crcFrom ) );
+		crcFrom = dst;
+	}
+	if( rawBytes == 0 )
+	{
+		// an empty image still needs one final stored block
+		const uint8_t empty[5] = { 1, 0, 0, 0xFF, 0xFF };
+		std::memcpy( dst, empty, 5 );
+		dst += 5;
+	}
+
+	const uint32_t adler = ( adlerB << 16 ) | adlerA;
+	for( int i = 0; i < 4; ++i )
+		*dst++ = uint8_t( adler >> ( 24 - i * 8 ) );
+
+	uint8_t* chunk = out.data() + chunkOffset;
+	for( int i = 0; i < 4; ++i )
+		chunk[i] = uint8_t( zlibBytes >> ( 24 - i * 8 ) );
+	crc = Crc32( crc, crcFrom, size_t( dst - crcFrom ) );
+	for( int i = 0; i < 4; ++i )
+		*dst++ = uint8_t( crc >> ( 24 - i * 8 ) );
+
+	PutChunk( out, "IEND", nullptr, 0 );
+}
+// -----------
+
+// --- Y4M ---
+// -----------
+void CaptureEncoder::EncodeY4mHeader( uint32_t width, uint32_t height, uint32_t framesPerSecond, std::vector<uint8_t>& out )
+{
+	const std::string header = "YUV4MPEG2 W" + std::to_string( width ) + " H" + std::to_string( height ) +
+		" F" + std::to_string( framesPerSecond ) + ":1 Ip A1:1 C420jpeg\n";
+	out.assign( header.begin(), header.end() );
+}
+
+void CaptureEncoder::EncodeY4mFrame( const CaptureImage& image, std::vector<uint8_t>& out )
+{
+	static const char frameHeader[] = "FRAME\n";
+	const uint32_t w = image.width, h = image.height;
+	const uint32_t cw = ( w + 1 ) / 2, ch = ( h + 1 ) / 2;
+	const int r = image.bgra ? 2 : 0;
+	const int b = image.bgra ? 0 : 2;
+
+	out.resize( sizeof( frameHeader ) - 1 + size_t( w ) * h + size_t( cw ) * ch * 2 );
+	std::memcpy( out.data(), frameHeader, sizeof( frameHeader ) - 1 );
+	uint8_t* yPlane = out.data() + sizeof( frameHeader ) - 1;
+	uint8_t* uPlane = yPlane + size_t( w ) * h;
+	uint8_t* vPlane = uPlane + size_t( cw ) * ch;
+
+	for( uint32_t y = 0; y < h; ++y )
+	{
+		const uint8_t* src = image.pixels + size_t( y ) * w * 4;
+		uint8_t* dst = yPlane + size_t( y ) * w;
+		for( uint32_t x = 0; x < w; ++x, src += 4 )
+			dst[x] = uint8_t( ( ( 66 * src[r] + 129 * src[1] + 25 * src[b] + 128 ) >> 8 ) + 16 );
+	}
+
+	for( uint32_t cy = 0; cy < ch; ++cy )
+	{
+		const uint32_t y0 = cy * 2, y1 = std::min( y0 + 1, h - 1 );
+		for( uint32_t cx = 0; cx < cw; ++cx )
+		{
+			const uint32_t x0 = cx * 2, x1 = std::min( x0 + 1, w - 1 );
+			const uint8_t* p[4] = {
+				image.pixels + ( size_t( y0 ) * w + x0 ) * 4, image.pixels + ( size_t( y0 ) * w + x1 ) * 4,
+				image.pixels + ( size_t( y1 ) * w + x0 ) * 4, image.pixels + ( size_t( y1 ) * w + x1 ) * 4 };
+			const int R = ( p[0][r] + p[1][r] + p[2][r] + p[3][r] + 2 ) / 4;
+			const int G = ( p[0][1] + p[1][1] + p[2][1] + p[3][1] + 2 ) / 4;
+			const int B = ( p[0][b] + p[1][b] + p[2][b] + p[3][b] + 2 ) / 4;
+			uPlane[size_t( cy ) * cw + cx] = uint8_t( ( ( -38 * R - 74 * G + 112 * B + 128 ) >> 8 ) + 128 );
+			vPlane[size_t( cy ) * cw + cx] = uint8_t( ( ( 112 * R - 94 * G - 18 * B + 128 ) >> 8 ) + 128 );
+		}
+	}
+}
+// -----------
\ No newline at end of file
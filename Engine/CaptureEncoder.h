@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class CaptureFormat
+{
+	Raw,	// pixels as read back, one file per frame
+	Png,	// one file per frame
+	Y4m		// one YUV 4:2:0 stream for the whole capture
+};
+
+const char* ToString( CaptureFormat format );
+// false for an unknown name, accepts "raw", "png" and "y4m"
+bool ParseCaptureFormat( const std::string& name, CaptureFormat& format );
+
+// tightly packed 8 bit, 4 channel pixels straight from a readback buffer
+struct CaptureImage
+{
+	const uint8_t* pixels = nullptr;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	bool bgra = false;	// B8G8R8A8 swapchain style order instead of R8G8B8A8
+};
+
+struct CaptureEncoder
+{
+	// PNG with stored ( uncompressed ) deflate blocks: no zlib dependency and no compression cost on the
+	// encoder threads, the files are about as large as the raw pixels
+	static void EncodePng( const CaptureImage& image, std::vector<uint8_t>& out );
+
+	static void EncodeY4mHeader( uint32_t width, uint32_t height, uint32_t framesPerSecond, std::vector<uint8_t>& out );
+	// BT.601 limited range, chroma averaged over 2x2 blocks
+	static void EncodeY4mFrame( const CaptureImage& image, std::vector<uint8_t>& out );
+};
\ No newline at end of file
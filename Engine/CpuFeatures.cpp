@@ -0,0 +1,110 @@
+#include "CpuFeatures.h"
+
+#if ENGINE_ARCH_X86
+#if defined( _MSC_VER )
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if ENGINE_ARCH_X86
+static void Cpuid( int leaf, int subleaf, unsigned int regs[4] )
+{
+#if defined( _MSC_VER )
+	int r[4];
+	__cpuidex( r, leaf, subleaf );
+	for( int i = 0; i < 4; ++i )
+		regs[i] = static_cast<unsigned int>( r[i] );
+#else
+	__cpuid_count( leaf, subleaf, regs[0], regs[1], regs[2], regs[3] );
+#endif
+}
+
+static unsigned long long ReadXcr0()
+{
+#if defined( _MSC_VER )
+	return _xgetbv( 0 );
+#else
+	unsigned int eax, edx;
+	__asm__ volatile( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+	return ( static_cast<unsigned long long>( edx ) << 32 ) | eax;
+#endif
+}
+
+static CpuFeatures Detect()
+{
+	CpuFeatures features;
+
+	unsigned int regs[4] = {};
+	Cpuid( 0, 0, regs );
+	const unsigned int maxLeaf = regs[0];
+
+	Cpuid( 1, 0, regs );
+	features.sse2 = ( regs[3] & ( 1u << 26 ) ) != 0;
+	const bool fma = ( regs[2] & ( 1u << 12 ) ) != 0;
+	const bool osxsave = ( regs[2] & ( 1u << 27 ) ) != 0;
+	const bool avx = ( regs[2] & ( 1u << 28 ) ) != 0;
+
+	// the CPU having AVX is not enough, the OS also has to save the YMM registers on context switch
+	const bool osYmm = osxsave && ( ReadXcr0() & 0x6 ) == 0x6;
+
+	bool avx2 = false;
+	if( maxLeaf >= 7 )
+	{
+		Cpuid( 7, 0, regs );
+		avx2 = ( regs[1] & ( 1u << 5 ) ) != 0;
+	}
+	features.avx2 = avx && avx2 && fma && osYmm;
+
+	return features;
+}
+#else
+static CpuFeatures Detect()
+{
+	CpuFeatures features;
+#if ENGINE_ARCH_ARM
+	// NEON is mandatory on AArch64
+	features.neon = true;
+#endif
+	return features;
+}
+#endif
+
+const CpuFeatures& CpuFeatures::Get()
+{
+	static const CpuFeatures features = Detect();
+	return features;
+}
+
+bool CpuFeatures::Supports( SimdLevel level ) const
+{
+	switch( level )
+	{
+	case SimdLevel::Scalar: return true;
+	case SimdLevel::SSE2: return sse2;
+	case SimdLevel::AVX2: return avx2;
+	case SimdLevel::NEON: return neon;
+	}
+	return false;
+}
+
+SimdLevel CpuFeatures::BestLevel() const
+{
+	if( avx2 ) return SimdLevel::AVX2;
+	if( sse2 ) return SimdLevel::SSE2;
+	if( neon ) return SimdLevel::NEON;
+	return SimdLevel::Scalar;
+}
+
+const char* ToString( SimdLevel level )
+{
+	switch( level )
+	{
+	case SimdLevel::Scalar: return "Scalar";
+	case SimdLevel::SSE2: return "SSE2";
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::NEON: return "NEON";
+	}
+	return "Unknown";
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#if defined( _M_X64 ) || defined( __x86_64__ ) || defined( _M_IX86 ) || defined( __i386__ )
+#define ENGINE_ARCH_X86 1
+#elif defined( _M_ARM64 ) || defined( __aarch64__ ) || defined( __ARM_NEON )
+#define ENGINE_ARCH_ARM 1
+#endif
+
+enum class SimdLevel
+{
+	Scalar,
+	SSE2,
+	AVX2,
+	NEON
+};
+
+const char* ToString( SimdLevel level );
+
+struct CpuFeatures
+{
+public:
+	// queried once, cached for the lifetime of the process
+	static const CpuFeatures& Get();
+
+	bool Supports( SimdLevel level ) const;
+	SimdLevel BestLevel() const;
+public:
+	bool sse2 = false;
+	bool avx2 = false;	// only set when FMA and OS support for the YMM state are present as well
+	bool neon = false;
+};
@@ -17,17 +17,4 @@ struct DebugUtilsMessengerEXT
 		else
 			return VK_ERROR_EXTENSION_NOT_PRESENT;
 	}
-
-	static void Destroy(
-		VkInstance instance,
-		VkDebugUtilsMessengerEXT debugMessenger,
-		const VkAllocationCallbacks* pAllocator
-	)
-	{
-		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr( instance, "vkDestroyDebugUtilsMessengerEXT" );
-		if( func != nullptr )
-			func( instance, debugMessenger, pAllocator );
-		else
-			throw std::runtime_error( "Failed destroy the debug messenger!" );
-	}
 };
\ No newline at end of file
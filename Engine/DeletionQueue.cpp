@@ -0,0 +1,190 @@
+#include "DeletionQueue.h"
+#include "VulkanHandle.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef NDEBUG
+static const char* ToString( VkObjectType type )
+{
+	switch( type )
+	{
+	case VK_OBJECT_TYPE_SEMAPHORE: return "VkSemaphore";
+	case VK_OBJECT_TYPE_FENCE: return "VkFence";
+	case VK_OBJECT_TYPE_DEVICE_MEMORY: return "VkDeviceMemory";
+	case VK_OBJECT_TYPE_BUFFER: return "VkBuffer";
+	case VK_OBJECT_TYPE_IMAGE: return "VkImage";
+	case VK_OBJECT_TYPE_QUERY_POOL: return "VkQueryPool";
+	case VK_OBJECT_TYPE_IMAGE_VIEW: return "VkImageView";
+	case VK_OBJECT_TYPE_SHADER_MODULE: return "VkShaderModule";
+	case VK_OBJECT_TYPE_PIPELINE_LAYOUT: return "VkPipelineLayout";
+	case VK_OBJECT_TYPE_RENDER_PASS: return "VkRenderPass";
+	case VK_OBJECT_TYPE_PIPELINE: return "VkPipeline";
+	case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: return "VkDescriptorSetLayout";
+	case VK_OBJECT_TYPE_SAMPLER: return "VkSampler";
+	case VK_OBJECT_TYPE_DESCRIPTOR_POOL: return "VkDescriptorPool";
+	case VK_OBJECT_TYPE_FRAMEBUFFER: return "VkFramebuffer";
+	case VK_OBJECT_TYPE_COMMAND_POOL: return "VkCommandPool";
+	case VK_OBJECT_TYPE_SWAPCHAIN_KHR: return "VkSwapchainKHR";
+	default: return "unknown object";
+	}
+}
+
+// handle bugs corrupt the driver state, stop right where they happen
+[[noreturn]] static void Fail( const char* what, VkObjectType type, uint64_t handle )
+{
+	std::cerr << "DeletionQueue: " << what << " " << ToString( type ) << " 0x" << std::hex << handle << std::dec << std::endl;
+	std::abort();
+}
+#endif
+
+void DeletionQueue::Init( VkDevice device, TimelineSync& sync )
+{
+	this->device = device;
+	this->sync = &sync;
+}
+
+void DeletionQueue::CleanUp()
+{
+	if( device == VK_NULL_HANDLE )
+		return;
+
+	// the open batch never got a submission to wait for, so wait for the whole device once
+	vkDeviceWaitIdle( device );
+
+	for( auto& batch : closed )
+	{
+		for( size_t i = batch.next; i < batch.entries.size(); ++i )
+			Destroy( batch.entries[i] );
+	}
+	for( const auto& entry : open )
+		Destroy( entry );
+
+#ifndef NDEBUG
+	for( const auto& leaked : owned )
+		std::cerr << "DeletionQueue: leaked " << ToString( leaked.first ) << " 0x" << std::hex << leaked.second << std::dec << std::endl;
+	owned.clear();
+	queued.clear();
+#endif
+
+	open.clear();
+	closed.clear();
+	spareBatches.clear();
+	pendingCount = 0;
+	device = VK_NULL_HANDLE;
+	sync = nullptr;
+}
+
+void DeletionQueue::Enqueue( VkObjectType type, uint64_t handle )
+{
+#ifndef NDEBUG
+	if( device == VK_NULL_HANDLE )
+		Fail( "released after CleanUp:", type, handle );
+	if( !queued.insert( { type, handle } ).second )
+		Fail( "double free of", type, handle );
+	owned.erase( { type, handle } );
+#endif
+
+	open.push_back( { type, handle } );
+	++pendingCount;
+}
+
+void DeletionQueue::EndFrame( std::initializer_list<TimelinePoint> lastUses )
+{
+	if( open.empty() )
+		return;
+
+	Batch batch;
+	for( const TimelinePoint& point : lastUses )
+	{
+		auto end = batch.lastUse.begin() + batch.lastUseCount;
+		auto same = std::find_if( batch.lastUse.begin(), end, [&point]( const TimelinePoint& p ) { return p.queue == point.queue; } );
+		if( same != end )
+			same->value = std::max( same->value, point.value );
+		else if( batch.lastUseCount < maxQueuesPerBatch )
+			batch.lastUse[batch.lastUseCount++] = point;
+		else
+			throw std::runtime_error( "DeletionQueue: a batch can wait on at most " + std::to_string( maxQueuesPerBatch ) + " queues" );
+	}
+	batch.entries.swap( open );
+	closed.push_back( std::move( batch ) );
+
+	if( !spareBatches.empty() )
+	{
+		open.swap( spareBatches.back() );
+		spareBatches.pop_back();
+	}
+}
+
+size_t DeletionQueue::Collect( size_t maxObjects )
+{
+	size_t destroyed = 0;
+	while( !closed.empty() && destroyed < maxObjects )
+	{
+		Batch& batch = closed.front();
+		const auto lastUseEnd = batch.lastUse.begin() + batch.lastUseCount;
+		if( !std::all_of( batch.lastUse.begin(), lastUseEnd, [this]( const TimelinePoint& p ) { return sync->IsComplete( p ); } ) )
+			break;
+
+		while( batch.next < batch.entries.size() && destroyed < maxObjects )
+		{
+			Destroy( batch.entries[batch.next++] );
+			++destroyed;
+		}
+		if( batch.next < batch.entries.size() )
+			break;
+
+		batch.entries.clear();
+		spareBatches.push_back( std::move( batch.entries ) );
+		closed.pop_front();
+	}
+	pendingCount -= destroyed;
+	return destroyed;
+}
+
+#ifndef NDEBUG
+void DeletionQueue::Track( VkObjectType type, uint64_t handle )
+{
+	// the driver only hands a value out again after it was really destroyed
+	if( queued.count( { type, handle } ) > 0 )
+		Fail( "use after release of", type, handle );
+	if( !owned.insert( { type, handle } ).second )
+		Fail( "owned twice:", type, handle );
+}
+
+void DeletionQueue::Untrack( VkObjectType type, uint64_t handle )
+{
+	owned.erase( { type, handle } );
+}
+#endif
+
+void DeletionQueue::Destroy( const Entry& entry )
+{
+#ifndef NDEBUG
+	queued.erase( { entry.type, entry.handle } );
+#endif
+
+	switch( entry.type )
+	{
+	case VK_OBJECT_TYPE_SEMAPHORE: vkDestroySemaphore( device, U64ToHandle<VkSemaphore>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_FENCE: vkDestroyFence( device, U64ToHandle<VkFence>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_DEVICE_MEMORY: vkFreeMemory( device, U64ToHandle<VkDeviceMemory>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_BUFFER: vkDestroyBuffer( device, U64ToHandle<VkBuffer>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_IMAGE: vkDestroyImage( device, U64ToHandle<VkImage>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_QUERY_POOL: vkDestroyQueryPool( device, U64ToHandle<VkQueryPool>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_IMAGE_VIEW: vkDestroyImageView( device, U64ToHandle<VkImageView>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_SHADER_MODULE: vkDestroyShaderModule( device, U64ToHandle<VkShaderModule>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_PIPELINE_LAYOUT: vkDestroyPipelineLayout( device, U64ToHandle<VkPipelineLayout>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_RENDER_PASS: vkDestroyRenderPass( device, U64ToHandle<VkRenderPass>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_PIPELINE: vkDestroyPipeline( device, U64ToHandle<VkPipeline>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: vkDestroyDescriptorSetLayout( device, U64ToHandle<VkDescriptorSetLayout>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_SAMPLER: vkDestroySampler( device, U64ToHandle<VkSampler>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_DESCRIPTOR_POOL: vkDestroyDescriptorPool( device, U64ToHandle<VkDescriptorPool>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_FRAMEBUFFER: vkDestroyFramebuffer( device, U64ToHandle<VkFramebuffer>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_COMMAND_POOL: vkDestroyCommandPool( device, U64ToHandle<VkCommandPool>( entry.handle ), nullptr ); break;
+	case VK_OBJECT_TYPE_SWAPCHAIN_KHR: vkDestroySwapchainKHR( device, U64ToHandle<VkSwapchainKHR>( entry.handle ), nullptr ); break;
+	default: break;
+	}
+}
\ No newline at end of file
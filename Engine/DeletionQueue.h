@@ -0,0 +1,87 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <array>
+#include <initializer_list>
+#include <deque>
+#include <cstdint>
+#ifndef NDEBUG
+#include <set>
+#include <utility>
+#endif
+
+#include "TimelineSync.h"
+
+// Destroys device objects once the GPU finished the last frame that could still use them, so
+// releasing a resource never stalls on vkDeviceWaitIdle. Objects released during a frame go into
+// that frame's batch, EndFrame() tags the batch with the last submission of every queue that could
+// still use them and Collect() destroys every finished batch in one go, normally once per frame
+// outside the recording code.
+//
+// Debug builds track every handle owned through UniqueHandle ( see VulkanHandle.h ) and abort on
+// double frees, CleanUp() lists the handles that were never released.
+class DeletionQueue
+{
+public:
+	DeletionQueue() = default;
+	DeletionQueue( const DeletionQueue& ) = delete;
+	DeletionQueue& operator=( const DeletionQueue& ) = delete;
+	~DeletionQueue() { CleanUp(); }
+
+	void Init( VkDevice device, TimelineSync& sync );
+	// waits for the device and destroys everything still queued, the device itself has to outlive this
+	void CleanUp();
+
+	void Enqueue( VkObjectType type, uint64_t handle );
+	// closes the open batch, it is destroyed once every point in lastUses is complete. Pass the last
+	// submission of each queue the frame used, points on the same queue are merged
+	void EndFrame( std::initializer_list<TimelinePoint> lastUses );
+	void EndFrame( const TimelinePoint& lastUse ) { EndFrame( { lastUse } ); }
+	// destroys up to maxObjects from finished batches, the rest waits for the next call. Never blocks
+	size_t Collect( size_t maxObjects = SIZE_MAX );
+
+	size_t Pending() const { return pendingCount; }
+	VkDevice Device() const { return device; }
+
+#ifdef NDEBUG
+	void Track( VkObjectType, uint64_t ) {}
+	void Untrack( VkObjectType, uint64_t ) {}
+#else
+	void Track( VkObjectType type, uint64_t handle );
+	void Untrack( VkObjectType type, uint64_t handle );
+#endif
+
+private:
+	struct Entry
+	{
+		VkObjectType type;
+		uint64_t handle;
+	};
+	// graphics, compute, transfer and present
+	static constexpr size_t maxQueuesPerBatch = 4;
+
+	struct Batch
+	{
+		std::array<TimelinePoint, maxQueuesPerBatch> lastUse;
+		size_t lastUseCount = 0;
+		std::vector<Entry> entries;
+		size_t next = 0;
+	};
+
+	void Destroy( const Entry& entry );
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	TimelineSync* sync = nullptr;
+
+	std::vector<Entry> open;
+	std::deque<Batch> closed;
+	std::vector<std::vector<Entry>> spareBatches;	// storage of destroyed batches, reused by EndFrame
+	size_t pendingCount = 0;
+
+#ifndef NDEBUG
+	std::set<std::pair<VkObjectType, uint64_t>> owned;
+	std::set<std::pair<VkObjectType, uint64_t>> queued;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,445 @@
+#include "FrameCapture.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <cstdio>
+
+static uint32_t FindHostMemoryType( const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t typeBits, VkMemoryPropertyFlags flags )
+{
+	for( uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i )
+	{
+		if( ( typeBits & ( 1u << i ) ) && ( memoryProperties.memoryTypes[i].propertyFlags & flags ) == flags )
+			return i;
+	}
+	return UINT32_MAX;
+}
+
+FrameCapture::~FrameCapture()
+{
+	try
+	{
+		CleanUp();
+	}
+	catch( const std::exception& )
+	{
+		// encoder errors only surface through an explicit CleanUp()
+	}
+}
+
+void FrameCapture::Init( VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, TimelineSync& sync,
+	DeletionQueue& deletionQueue, VkExtent2D extent, VkFormat format, const Options& options )
+{
+	switch( format )
+	{
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		bgra = true;
+		break;
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+		bgra = false;
+		break;
+	default:
+		throw std::runtime_error( "Failed to set up frame capture: only 8 bit RGBA and BGRA formats can be captured" );
+	}
+
+	this->device = device;
+	this->sync = &sync;
+	this->extent = extent;
+	this->options = options;
+	this->options.readbackSlots = std::max( this->options.readbackSlots, 1u );
+	this->options.tileRows = std::max( this->options.tileRows, 1u );
+	frameBytes = VkDeviceSize( extent.width ) * extent.height * 4;
+
+	std::error_code error;
+	std::filesystem::create_directories( this->options.directory, error );
+	if( error )
+		throw std::runtime_error( "Failed to create capture directory " + this->options.directory + ": " + error.message() );
+
+	// --- READBACK BUFFERS ---
+	// -----------
+	// cached memory makes the encoders' reads fast, it is usually not coherent so Poll() invalidates
+	for( uint32_t i = 0; i < this->options.readbackSlots; ++i )
+	{
+		auto slot = std::make_unique<Slot>();
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = frameBytes;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		if( vkCreateBuffer( device, &bufferInfo, nullptr, &buffer ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to create capture readback buffer" );
+		slot->buffer = UniqueBuffer( deletionQueue, buffer );
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements( device, buffer, &requirements );
+		uint32_t typeIndex = FindHostMemoryType( memoryProperties, requirements.memoryTypeBits,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT );
+		if( typeIndex == UINT32_MAX )
+			typeIndex = FindHostMemoryType( memoryProperties, requirements.memoryTypeBits,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+		if( typeIndex == UINT32_MAX )
+			throw std::runtime_error( "Failed to find host visible memory for capture readback" );
+		coherent = ( memoryProperties.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) != 0;
+
+		VkMemoryAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = requirements.size;
+		allocateInfo.memoryTypeIndex = typeIndex;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		if( vkAllocateMemory( device, &allocateInfo, nullptr, &memory ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to allocate capture readback memory" );
+		slot->memory = UniqueDeviceMemory( deletionQueue, memory );
+		slot->memoryHandle = memory;
+
+		if( vkBindBufferMemory( device, buffer, memory, 0 ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to bind capture readback memory" );
+
+		// stays mapped, freeing the memory unmaps it
+		void* mapped = nullptr;
+		if( vkMapMemory( device, memory, 0, VK_WHOLE_SIZE, 0, &mapped ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to map capture readback memory" );
+		slot->mapped = static_cast<const uint8_t*>( mapped );
+
+		slots.push_back( std::move( slot ) );
+	}
+	// -----------
+
+	if( this->options.format == CaptureFormat::Y4m )
+	{
+		std::vector<uint8_t> header;
+		CaptureEncoder::EncodeY4mHeader( extent.width, extent.height, this->options.framesPerSecond, header );
+		y4mFile.Open( this->options.directory + "/capture.y4m", this->options.writeBufferBytes, this->options.directIo );
+		y4mFile.Write( header.data(), header.size() );
+	}
+
+	// --- ENCODERS ---
+	// -----------
+	uint32_t threadCount = this->options.encoderThreads;
+	if( threadCount == 0 )
+		threadCount = std::max( std::thread::hardware_concurrency(), 2u ) - 1;
+	stopping = false;
+	for( uint32_t i = 0; i < threadCount; ++i )
+		encoders.emplace_back( &FrameCapture::EncoderLoop, this );
+	// -----------
+}
+
+void FrameCapture::CleanUp()
+{
+	if( device == VK_NULL_HANDLE )
+		return;
+
+	// recorded but never submitted, these copies will not happen
+	for( Slot* slot : recorded )
+		slot->state = SlotState::Free;
+	recorded.clear();
+
+	// the rest of the frames still go to disk
+	while( !inFlight.empty() )
+	{
+		sync->Wait( inFlight.front()->point );
+		HandOver();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		stopping = true;
+	}
+	jobReady.notify_all();
+	for( std::thread& encoder : encoders )
+		encoder.join();
+	encoders.clear();
+
+	if( y4mFile.IsOpen() )
+	{
+		try
+		{
+			y4mFile.Close();
+		}
+		catch( const std::exception& e )
+		{
+			if( encoderError.empty() )
+				encoderError = e.what();
+		}
+	}
+
+	// the buffers go through the deletion queue like everything else
+	slots.clear();
+	device = VK_NULL_HANDLE;
+	sync = nullptr;
+
+	RethrowEncoderError();
+}
+
+bool FrameCapture::Record( VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess )
+{
+	Slot* slot = AcquireSlot();
+	if( slot == nullptr )
+	{
+		++stats.framesDropped;
+		return false;
+	}
+
+	if( stats.framesCaptured == 0 )
+		firstCapture = std::chrono::steady_clock::now();
+
+	VkImageMemoryBarrier toTransfer{};
+	toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	toTransfer.srcAccessMask = srcAccess;
+	toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	toTransfer.oldLayout = layout;
+	toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.image = image;
+	toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdPipelineBarrier( commandBuffer, srcStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer );
+
+	// one region per band of rows, lets the driver spread a 4K copy instead of walking it as one block
+	regions.clear();
+	for( uint32_t y = 0; y < extent.height; y += options.tileRows )
+	{
+		VkBufferImageCopy region{};
+		region.bufferOffset = VkDeviceSize( y ) * extent.width * 4;
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageOffset = { 0, static_cast<int32_t>( y ), 0 };
+		region.imageExtent = { extent.width, std::min( options.tileRows, extent.height - y ), 1 };
+		regions.push_back( region );
+	}
+	vkCmdCopyImageToBuffer( commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->buffer.Get(),
+		static_cast<uint32_t>( regions.size() ), regions.data() );
+
+	VkBufferMemoryBarrier toHost{};
+	toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.buffer = slot->buffer.Get();
+	toHost.offset = 0;
+	toHost.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &toHost, 0, nullptr );
+
+	slot->sequence = nextSequence++;
+	slot->state = SlotState::Recorded;
+	recorded.push_back( slot );
+	++stats.framesCaptured;
+	return true;
+}
+
+void FrameCapture::Submitted( const TimelinePoint& point )
+{
+	for( Slot* slot : recorded )
+	{
+		slot->point = point;
+		slot->state = SlotState::InFlight;
+		inFlight.push_back( slot );
+	}
+	recorded.clear();
+	stats.maxReadbacksInFlight = std::max( stats.maxReadbacksInFlight, static_cast<uint32_t>( inFlight.size() ) );
+}
+
+void FrameCapture::Poll()
+{
+	RethrowEncoderError();
+	HandOver();
+}
+
+void FrameCapture::HandOver()
+{
+	// submissions complete in order, the first unfinished one ends the scan
+	while( !inFlight.empty() && sync->IsComplete( inFlight.front()->point ) )
+	{
+		Slot* slot = inFlight.front();
+		inFlight.pop_front();
+
+		if( !coherent )
+		{
+			VkMappedMemoryRange range{};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = slot->memoryHandle;
+			range.offset = 0;
+			range.size = VK_WHOLE_SIZE;
+			vkInvalidateMappedMemoryRanges( device, 1, &range );
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			slot->state = SlotState::Encoding;
+			jobs.push_back( slot );
+			stats.maxEncodeQueueDepth = std::max( stats.maxEncodeQueueDepth, static_cast<uint32_t>( jobs.size() ) );
+		}
+		jobReady.notify_one();
+	}
+}
+
+FrameCapture::Stats FrameCapture::GetStats() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	Stats result = stats;
+	result.readbacksInFlight = static_cast<uint32_t>( recorded.size() + inFlight.size() );
+	result.encodeQueueDepth = static_cast<uint32_t>( jobs.size() );
+	if( result.framesWritten > 0 )
+		result.seconds = std::chrono::duration<double>( lastWrite - firstCapture ).count();
+	return result;
+}
+
+FrameCapture::Slot* FrameCapture::AcquireSlot()
+{
+	if( slots.empty() )
+		throw std::runtime_error( "FrameCapture::Record called before Init" );
+
+	// slots are used round robin, so the next one is always the oldest capture
+	Slot* slot = slots[nextSlot].get();
+	HandOver();
+
+	std::unique_lock<std::mutex> lock( mutex );
+	if( slot->state == SlotState::Recorded )
+		throw std::runtime_error( "FrameCapture: more frames recorded than readback slots before Submitted()" );
+	if( slot->state != SlotState::Free )
+	{
+		if( options.dropWhenFull )
+			return nullptr;
+
+		++stats.cpuWaits;
+		if( slot->state == SlotState::InFlight )
+		{
+			lock.unlock();
+			sync->Wait( slot->point );
+			HandOver();
+			lock.lock();
+		}
+		slotFreed.wait( lock, [slot] { return slot->state == SlotState::Free; } );
+	}
+
+	nextSlot = ( nextSlot + 1 ) % slots.size();
+	return slot;
+}
+
+void FrameCapture::EncoderLoop()
+{
+	std::vector<uint8_t> scratch;
+	for( ;; )
+	{
+		Slot* slot = nullptr;
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			jobReady.wait( lock, [this] { return stopping || !jobs.empty(); } );
+			if( jobs.empty() )
+				return;
+			slot = jobs.front();
+			jobs.pop_front();
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		uint64_t written = 0;
+		std::string error;
+		try
+		{
+			written = Encode( *slot, scratch );
+		}
+		catch( const std::exception& e )
+		{
+			error = e.what();
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			if( error.empty() )
+			{
+				++stats.framesWritten;
+				stats.bytesWritten += written;
+			}
+			else if( encoderError.empty() )
+				encoderError = error;
+			stats.encodeMs += std::chrono::duration<double, std::milli>( end - start ).count();
+			lastWrite = std::max( lastWrite, end );
+			slot->state = SlotState::Free;
+		}
+		slotFreed.notify_all();
+	}
+}
+
+uint64_t FrameCapture::Encode( const Slot& slot, std::vector<uint8_t>& scratch )
+{
+	const CaptureImage image{ slot.mapped, extent.width, extent.height, bgra };
+
+	switch( options.format )
+	{
+	case CaptureFormat::Raw:
+	{
+		BufferedFile file;
+		file.Open( FramePath( slot.sequence, "raw" ), options.writeBufferBytes, options.directIo );
+		file.Write( slot.mapped, static_cast<size_t>( frameBytes ) );
+		file.Close();
+		return frameBytes;
+	}
+	case CaptureFormat::Png:
+	{
+		CaptureEncoder::EncodePng( image, scratch );
+		BufferedFile file;
+		file.Open( FramePath( slot.sequence, "png" ), options.writeBufferBytes, options.directIo );
+		file.Write( scratch.data(), scratch.size() );
+		file.Close();
+		return scratch.size();
+	}
+	case CaptureFormat::Y4m:
+	{
+		// the turn has to pass on even when this frame fails, otherwise every later frame waits forever
+		std::exception_ptr error;
+		try
+		{
+			CaptureEncoder::EncodeY4mFrame( image, scratch );
+		}
+		catch( ... )
+		{
+			error = std::current_exception();
+		}
+
+		std::unique_lock<std::mutex> lock( y4mMutex );
+		y4mTurn.wait( lock, [this, &slot] { return nextY4mSequence == slot.sequence; } );
+		if( !error )
+		{
+			try
+			{
+				y4mFile.Write( scratch.data(), scratch.size() );
+			}
+			catch( ... )
+			{
+				error = std::current_exception();
+			}
+		}
+		++nextY4mSequence;
+		lock.unlock();
+		y4mTurn.notify_all();
+
+		if( error )
+			std::rethrow_exception( error );
+		return scratch.size();
+	}
+	}
+	return 0;
+}
+
+std::string FrameCapture::FramePath( uint64_t sequence, const char* extension ) const
+{
+	char name[32];
+	std::snprintf( name, sizeof( name ), "/frame_%06llu.", static_cast<unsigned long long>( sequence ) );
+	return options.directory + name + extension;
+}
+
+void FrameCapture::RethrowEncoderError()
+{
+	std::string error;
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		error.swap( encoderError );
+	}
+	if( !error.empty() )
+		throw std::runtime_error( "Frame capture failed: " + error );
+}
\ No newline at end of file
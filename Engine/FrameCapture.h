@@ -0,0 +1,133 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "TimelineSync.h"
+#include "DeletionQueue.h"
+#include "VulkanHandle.h"
+#include "CaptureEncoder.h"
+#include "BufferedFile.h"
+
+// Writes rendered frames to disk without stalling the frame loop. Record() copies the image band by
+// band into one of a ring of host-visible readback buffers, Poll() hands finished readbacks to a pool
+// of encoder threads which read the mapped memory directly and write through BufferedFile. The CPU
+// only blocks when every readback buffer is busy, unless dropWhenFull is set.
+class FrameCapture
+{
+public:
+	struct Options
+	{
+		std::string directory = "capture";
+		CaptureFormat format = CaptureFormat::Raw;	// PNG encodes a 4K frame in ~45 ms per thread, raw keeps up
+		uint32_t readbackSlots = 4;
+		uint32_t encoderThreads = 0;	// 0 picks hardware threads - 1
+		uint32_t tileRows = 128;		// rows per copy region
+		size_t writeBufferBytes = 8u << 20;
+		bool directIo = false;			// O_DIRECT where the platform and filesystem allow it
+		bool dropWhenFull = false;		// drop frames instead of waiting for a free readback buffer
+		uint32_t framesPerSecond = 60;	// only written into the Y4M header
+	};
+
+	struct Stats
+	{
+		uint64_t framesCaptured = 0;
+		uint64_t framesDropped = 0;
+		uint64_t framesWritten = 0;
+		uint64_t bytesWritten = 0;
+		uint64_t cpuWaits = 0;				// Record() had to block for a free readback buffer
+		uint32_t readbacksInFlight = 0;
+		uint32_t maxReadbacksInFlight = 0;
+		uint32_t encodeQueueDepth = 0;
+		uint32_t maxEncodeQueueDepth = 0;
+		double encodeMs = 0.0;				// summed over all encoder threads
+		double seconds = 0.0;				// first Record() to the last written frame
+
+		double FramesPerSecond() const { return seconds > 0.0 ? framesWritten / seconds : 0.0; }
+		double MegabytesPerSecond() const { return seconds > 0.0 ? bytesWritten / seconds / ( 1024.0 * 1024.0 ) : 0.0; }
+	};
+
+public:
+	FrameCapture() = default;
+	FrameCapture( const FrameCapture& ) = delete;
+	FrameCapture& operator=( const FrameCapture& ) = delete;
+	~FrameCapture();
+
+	// format has to be an 8 bit RGBA or BGRA format
+	void Init( VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, TimelineSync& sync,
+		DeletionQueue& deletionQueue, VkExtent2D extent, VkFormat format, const Options& options );
+	// waits until every captured frame is on disk, rethrows the first encoder error
+	void CleanUp();
+
+	// records the copy of image, which is left in TRANSFER_SRC_OPTIMAL. False when the frame was dropped
+	bool Record( VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess );
+	// the submission that carries the copies recorded since the last call
+	void Submitted( const TimelinePoint& point );
+	// hands finished readbacks to the encoders, never blocks. Rethrows encoder errors
+	void Poll();
+
+	Stats GetStats() const;
+
+private:
+	enum class SlotState { Free, Recorded, InFlight, Encoding };
+
+	struct Slot
+	{
+		UniqueBuffer buffer;
+		UniqueDeviceMemory memory;
+		VkDeviceMemory memoryHandle = VK_NULL_HANDLE;
+		const uint8_t* mapped = nullptr;
+		TimelinePoint point;
+		uint64_t sequence = 0;
+		SlotState state = SlotState::Free;	// guarded by mutex once the slot was handed to the encoders
+	};
+
+	Slot* AcquireSlot();
+	// moves finished readbacks to the encoders
+	void HandOver();
+	void EncoderLoop();
+	uint64_t Encode( const Slot& slot, std::vector<uint8_t>& scratch );
+	std::string FramePath( uint64_t sequence, const char* extension ) const;
+	void RethrowEncoderError();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	TimelineSync* sync = nullptr;
+	Options options;
+	VkExtent2D extent{};
+	bool bgra = false;
+	bool coherent = true;
+	VkDeviceSize frameBytes = 0;
+
+	std::vector<std::unique_ptr<Slot>> slots;
+	size_t nextSlot = 0;
+	uint64_t nextSequence = 0;
+	std::vector<Slot*> recorded;	// waiting for Submitted()
+	std::deque<Slot*> inFlight;		// submitted, in submission order
+	std::vector<VkBufferImageCopy> regions;
+
+	std::vector<std::thread> encoders;
+	mutable std::mutex mutex;
+	std::condition_variable jobReady;
+	std::condition_variable slotFreed;
+	std::deque<Slot*> jobs;
+	bool stopping = false;
+	std::string encoderError;
+
+	// Y4M is one stream, frames are converted in parallel and appended in sequence order
+	std::mutex y4mMutex;
+	std::condition_variable y4mTurn;
+	BufferedFile y4mFile;
+	uint64_t nextY4mSequence = 0;
+
+	Stats stats;
+	std::chrono::steady_clock::time_point firstCapture;
+	std::chrono::steady_clock::time_point lastWrite;
+};
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+// glfwInit / glfwTerminate and the window, the first member of HelloTriangleApp so it outlives the surface
+class GlfwWindow
+{
+public:
+	GlfwWindow() = default;
+	GlfwWindow( const GlfwWindow& ) = delete;
+	GlfwWindow& operator=( const GlfwWindow& ) = delete;
+	~GlfwWindow()
+	{
+		if( window != nullptr )
+			glfwDestroyWindow( window );
+		if( initialized )
+			glfwTerminate();
+	}
+
+	void Create( int width, int height, const char* title )
+	{
+		initialized = glfwInit() == GLFW_TRUE;
+		glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+		glfwWindowHint( GLFW_RESIZABLE, GLFW_FALSE );
+
+		window = glfwCreateWindow( width, height, title, nullptr, nullptr );
+	}
+	GLFWwindow* Get() const { return window; }
+
+private:
+	GLFWwindow* window = nullptr;
+	bool initialized = false;
+};
\ No newline at end of file
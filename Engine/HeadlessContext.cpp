@@ -0,0 +1,160 @@
+#include "HeadlessContext.h"
+#include "TimelineSync.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+static const char* const headlessValidationLayer = "VK_LAYER_KHRONOS_validation";
+
+void HeadlessContext::Init( const Options& options )
+{
+	InitInstance( options.enableValidation );
+	PickPhysicalDevice( options );
+	CreateLogicalDevice( options.enableValidation );
+}
+
+uint32_t HeadlessContext::FindMemoryType( uint32_t typeBits, VkMemoryPropertyFlags memoryFlags ) const
+{
+	for( uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i )
+	{
+		if( ( typeBits & ( 1u << i ) ) && ( memoryProperties.memoryTypes[i].propertyFlags & memoryFlags ) == memoryFlags )
+			return i;
+	}
+	throw std::runtime_error( "Failed to find a suitable memory type!" );
+}
+
+void HeadlessContext::InitInstance( bool enableValidation )
+{
+	if( enableValidation )
+	{
+		uint32_t layerCount = 0;
+		vkEnumerateInstanceLayerProperties( &layerCount, nullptr );
+		std::vector<VkLayerProperties> layers( layerCount );
+		vkEnumerateInstanceLayerProperties( &layerCount, layers.data() );
+
+		const bool found = std::any_of( layers.begin(), layers.end(),
+			[]( const VkLayerProperties& l ) { return std::strcmp( l.layerName, headlessValidationLayer ) == 0; } );
+		if( !found )
+			throw std::runtime_error( "Validation Layer requested, but not available!" );
+	}
+
+	VkApplicationInfo appInfo{};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName = "Headless";
+	appInfo.applicationVersion = VK_MAKE_VERSION( 1, 0, 0 );
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+	appInfo.pEngineName = "No Engine";
+	appInfo.engineVersion = VK_MAKE_VERSION( 1, 0, 0 );
+
+	// no surface, so no window system extensions either
+	const auto extensions = TimelineSupport::OptionalInstanceExtensions();
+	VkInstanceCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	createInfo.pApplicationInfo = &appInfo;
+	createInfo.enabledExtensionCount = static_cast<uint32_t>( extensions.size() );
+	createInfo.ppEnabledExtensionNames = extensions.empty() ? nullptr : extensions.data();
+	createInfo.enabledLayerCount = enableValidation ? 1u : 0u;
+	createInfo.ppEnabledLayerNames = enableValidation ? &headlessValidationLayer : nullptr;
+
+	VkInstance createdInstance;
+	if( vkCreateInstance( &createInfo, nullptr, &createdInstance ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to create instance\n" );
+	instance = UniqueInstance( createdInstance );
+}
+
+void HeadlessContext::PickPhysicalDevice( const Options& options )
+{
+	uint32_t physicalDeviceCount = 0;
+	vkEnumeratePhysicalDevices( instance.Get(), &physicalDeviceCount, nullptr );
+
+	if( physicalDeviceCount == 0 )
+		throw std::runtime_error( "Failed to find GPUs with Vulkan Support!" );
+
+	std::vector<VkPhysicalDevice> devices( physicalDeviceCount );
+	vkEnumeratePhysicalDevices( instance.Get(), &physicalDeviceCount, devices.data() );
+
+	// enumeration order is stable for a given driver set, so the pick is deterministic
+	VkPhysicalDevice fallback = VK_NULL_HANDLE;
+	for( const auto& candidate : devices )
+	{
+		if( !FindGraphicsFamily( candidate ).has_value() )
+			continue;
+
+		VkPhysicalDeviceProperties candidateProperties;
+		vkGetPhysicalDeviceProperties( candidate, &candidateProperties );
+		const bool isCpu = candidateProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+
+		if( isCpu && options.preferCpuDevice )
+		{
+			physicalDevice = candidate;
+			break;
+		}
+		if( fallback == VK_NULL_HANDLE && ( isCpu || !options.requireCpuDevice ) )
+			fallback = candidate;
+	}
+	if( physicalDevice == VK_NULL_HANDLE )
+		physicalDevice = fallback;
+
+	if( physicalDevice == VK_NULL_HANDLE )
+		throw std::runtime_error( options.requireCpuDevice ? "Failed to find a CPU Vulkan device!" : "Failed to find suitable GPUs!" );
+
+	vkGetPhysicalDeviceProperties( physicalDevice, &properties );
+	vkGetPhysicalDeviceMemoryProperties( physicalDevice, &memoryProperties );
+}
+
+void HeadlessContext::CreateLogicalDevice( bool enableValidation )
+{
+	graphicsFamily = FindGraphicsFamily( physicalDevice ).value();
+
+	float queuePriority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo{};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex = graphicsFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &queuePriority;
+
+	TimelineSupport timeline = TimelineSupport::Query( instance.Get(), physicalDevice );
+	const char* const timelineExtension = VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME;
+
+	VkPhysicalDeviceFeatures physicalDeviceFeatures{};
+	VkDeviceCreateInfo deviceInfo{};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.pNext = timeline.supported ? &timeline.features : nullptr;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pEnabledFeatures = &physicalDeviceFeatures;
+	deviceInfo.enabledExtensionCount = timeline.supported ? 1u : 0u;
+	deviceInfo.ppEnabledExtensionNames = timeline.supported ? &timelineExtension : nullptr;
+	deviceInfo.enabledLayerCount = enableValidation ? 1u : 0u;
+	deviceInfo.ppEnabledLayerNames = enableValidation ? &headlessValidationLayer : nullptr;
+
+	VkDevice createdDevice;
+	if( vkCreateDevice( physicalDevice, &deviceInfo, nullptr, &createdDevice ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to create Logical Device" );
+	device = UniqueDevice( createdDevice );
+
+	timelineSemaphores = timeline.supported;
+	vkGetDeviceQueue( device.Get(), graphicsFamily, 0, &graphicsQueue );
+
+	uint32_t queueFamiliesCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamiliesCount, nullptr );
+	std::vector<VkQueueFamilyProperties> queueFamilies( queueFamiliesCount );
+	vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamiliesCount, queueFamilies.data() );
+	timestampValidBits = queueFamilies[graphicsFamily].timestampValidBits;
+}
+
+std::optional<uint32_t> HeadlessContext::FindGraphicsFamily( VkPhysicalDevice candidate ) const
+{
+	uint32_t queueFamiliesCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties( candidate, &queueFamiliesCount, nullptr );
+	std::vector<VkQueueFamilyProperties> queueFamilies( queueFamiliesCount );
+	vkGetPhysicalDeviceQueueFamilyProperties( candidate, &queueFamiliesCount, queueFamilies.data() );
+
+	for( uint32_t i = 0; i < queueFamiliesCount; ++i )
+	{
+		if( queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT )
+			return i;
+	}
+	return std::nullopt;
+}
\ No newline at end of file
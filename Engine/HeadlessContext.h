@@ -0,0 +1,46 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <optional>
+
+#include "VulkanHandle.h"
+
+// Instance + logical device without a window, surface or swapchain.
+// Used by the frame benchmark and offline render jobs, e.g. on lavapipe in CI.
+// Both are destroyed with the context, so everything created from the device has to go first.
+class HeadlessContext
+{
+public:
+	struct Options
+	{
+		bool preferCpuDevice = true;	// pick VK_PHYSICAL_DEVICE_TYPE_CPU ( lavapipe ) when there is one
+		bool requireCpuDevice = false;	// fail instead of falling back to a GPU
+		bool enableValidation = false;
+	};
+
+public:
+	void Init( const Options& options );
+
+	uint32_t FindMemoryType( uint32_t typeBits, VkMemoryPropertyFlags memoryFlags ) const;
+
+private:
+	void InitInstance( bool enableValidation );
+	void PickPhysicalDevice( const Options& options );
+	void CreateLogicalDevice( bool enableValidation );
+
+	std::optional<uint32_t> FindGraphicsFamily( VkPhysicalDevice physicalDevice ) const;
+
+public:
+	UniqueInstance instance;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties properties{};
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	UniqueDevice device;
+	uint32_t graphicsFamily = 0;
+	VkQueue graphicsQueue = VK_NULL_HANDLE;
+	// 0 when the graphics queue can not write timestamps
+	uint32_t timestampValidBits = 0;
+	// VK_KHR_timeline_semaphore enabled, see TimelineSync
+	bool timelineSemaphores = false;
+};
\ No newline at end of file
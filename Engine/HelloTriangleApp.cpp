@@ -1,5 +1,6 @@
 #include "HelloTriangleApp.h"
 #include <algorithm>
+#include <cstdlib>
 
 void HelloTriangleApp::Run()
 {
@@ -11,11 +12,7 @@ void HelloTriangleApp::Run()
 
 void HelloTriangleApp::InitWindow()
 {
-	glfwInit();
-	glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
-	glfwWindowHint( GLFW_RESIZABLE, GLFW_FALSE );
-
-	window = glfwCreateWindow( ScreenWidth, ScreenHeight, "Learning Vulkan", nullptr, nullptr );
+	window.Create( ScreenWidth, ScreenHeight, "Learning Vulkan" );
 }
 
 void HelloTriangleApp::InitVulkan()
@@ -31,27 +28,29 @@ void HelloTriangleApp::InitVulkan()
 
 void HelloTriangleApp::MainLoop()
 {
-	while( !glfwWindowShouldClose( window ) )
+	while( !glfwWindowShouldClose( window.Get() ) )
+	{
+		sync.BeginFrame();
 		glfwPollEvents();
+
+		// objects released this frame are destroyed once its last submission finished
+		deletionQueue.EndFrame( sync.LastSubmitted( graphicsTimeline ) );
+		deletionQueue.Collect();
+		sync.CollectRetired();
+	}
 }
 
 void HelloTriangleApp::CleanUp()
 {
-	for( auto& imageView : swapchainImageViews )
-		vkDestroyImageView( device, imageView, nullptr );
-
-	vkDestroySwapchainKHR( device, swapchain, nullptr );
+	sync.WaitIdle();
 
-	vkDestroyDevice( device, nullptr );
+	const TimelineSync::FrameStats stats = sync.Stats();
+	std::cout << "sync: " << ( sync.UsesTimelineSemaphores() ? "timeline semaphores" : "fences" ) << ", "
+		<< stats.frames << " frames, CPU waits per frame avg "
+		<< ( stats.frames > 0 ? static_cast<double>( stats.totalCpuWaits ) / stats.frames : 0.0 )
+		<< " max " << stats.maxCpuWaitsPerFrame << std::endl;
 
-	if( enableValidationLayer )
-		DebugUtilsMessengerEXT::Destroy( instance, debugMessenger, nullptr );
-
-	vkDestroySurfaceKHR( instance, surface, nullptr );
-	vkDestroyInstance( instance, nullptr );
-	glfwDestroyWindow( window );
-
-	glfwTerminate();
+	// the rest goes with the members, in reverse declaration order ( see HelloTriangleApp.h )
 }
 
 void HelloTriangleApp::InitInstance()
@@ -90,8 +89,10 @@ void HelloTriangleApp::InitInstance()
 		createInfo.pNext = nullptr;
 	}
 
-	if( vkCreateInstance( &createInfo, nullptr, &instance ) != VK_SUCCESS )
+	VkInstance createdInstance;
+	if( vkCreateInstance( &createInfo, nullptr, &createdInstance ) != VK_SUCCESS )
 		throw std::runtime_error( "Failed to create instance\n" );
+	instance = UniqueInstance( createdInstance );
 
 	uint32_t vkExtensionsCount = 0U;
 	vkEnumerateInstanceExtensionProperties( nullptr, &vkExtensionsCount, nullptr );
@@ -105,13 +106,13 @@ void HelloTriangleApp::InitInstance()
 void HelloTriangleApp::PickPhysicalDevice()
 {
 	uint32_t physicalDeviceCount = 0;
-	vkEnumeratePhysicalDevices( instance, &physicalDeviceCount, nullptr );
+	vkEnumeratePhysicalDevices( instance.Get(), &physicalDeviceCount, nullptr );
 
 	if( physicalDeviceCount == 0 )
 		throw std::runtime_error( "Failed to find GPUs with Vulkan Support!" );
 
 	std::vector<VkPhysicalDevice> devices( physicalDeviceCount );
-	vkEnumeratePhysicalDevices( instance, &physicalDeviceCount, devices.data() );
+	vkEnumeratePhysicalDevices( instance.Get(), &physicalDeviceCount, devices.data() );
 
 	for( const auto& device : devices )
 	{
@@ -173,8 +174,21 @@ void HelloTriangleApp::CreateLogicalDevice()
 
 	VkPhysicalDeviceFeatures physicalDeviceFeatures = GetPhysicalDeviceFeatures( physicalDevice );
 	deviceInfo.pEnabledFeatures = &physicalDeviceFeatures;
-	deviceInfo.enabledExtensionCount = static_cast<uint32_t>( deviceExtensionsNeeded.size() );
-	deviceInfo.ppEnabledExtensionNames = deviceExtensionsNeeded.data();
+
+	// timeline semaphores are optional, TimelineSync falls back to fences without them
+	TimelineSupport timeline = TimelineSupport::Query( instance.Get(), physicalDevice );
+	std::vector<const char*> deviceExtensions( deviceExtensionsNeeded );
+	if( timeline.supported )
+	{
+		deviceExtensions.push_back( VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME );
+		deviceInfo.pNext = &timeline.features;
+	}
+	// sRGB views of UNORM swapchain images and the other way around
+	swapchainFormatSupport = SwapchainFormatSupport::Query( physicalDevice );
+	if( swapchainFormatSupport.mutableFormat )
+		deviceExtensions.insert( deviceExtensions.end(), swapchainFormatSupport.deviceExtensions.begin(), swapchainFormatSupport.deviceExtensions.end() );
+	deviceInfo.enabledExtensionCount = static_cast<uint32_t>( deviceExtensions.size() );
+	deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
 	if( enableValidationLayer )
 	{
 		deviceInfo.enabledLayerCount = static_cast<uint32_t>( validationLayer.size() );
@@ -186,11 +200,17 @@ void HelloTriangleApp::CreateLogicalDevice()
 		deviceInfo.ppEnabledLayerNames = nullptr;
 	}
 
-	if( vkCreateDevice( physicalDevice, &deviceInfo, nullptr, &device ) != VK_SUCCESS )
+	VkDevice createdDevice;
+	if( vkCreateDevice( physicalDevice, &deviceInfo, nullptr, &createdDevice ) != VK_SUCCESS )
 		throw std::runtime_error( "Failed to create Logical Device" );
+	device = UniqueDevice( createdDevice );
 
-	vkGetDeviceQueue( device, indices.GetGraphicsFamilyValue(), 0, &graphicsQueue );
-	vkGetDeviceQueue( device, indices.GetPresentFamilyValue(), 0, &presentQueue );
+	vkGetDeviceQueue( device.Get(), indices.GetGraphicsFamilyValue(), 0, &graphicsQueue );
+	vkGetDeviceQueue( device.Get(), indices.GetPresentFamilyValue(), 0, &presentQueue );
+
+	sync.Init( device.Get(), timeline.supported );
+	graphicsTimeline = sync.RegisterQueue( graphicsQueue );
+	deletionQueue.Init( device.Get(), sync );
 }
 
 VKAPI_ATTR VkBool32 VKAPI_CALL HelloTriangleApp::debugCallback( 
@@ -222,8 +242,10 @@ void HelloTriangleApp::SetupDebugMessenger()
 	VkDebugUtilsMessengerCreateInfoEXT createInfo{};
 	PopulateDebugUtilsMessengerCreateInfoEXT( createInfo );
 
-	if( DebugUtilsMessengerEXT::Create( instance, &createInfo, nullptr, &debugMessenger ) != VK_SUCCESS )
+	VkDebugUtilsMessengerEXT createdMessenger;
+	if( DebugUtilsMessengerEXT::Create( instance.Get(), &createInfo, nullptr, &createdMessenger ) != VK_SUCCESS )
 		throw std::runtime_error( "Failed to setup debug messenger!" );
+	debugMessenger = UniqueDebugMessenger( instance.Get(), createdMessenger );
 }
 
 void HelloTriangleApp::CreateSurface()
@@ -238,14 +260,17 @@ void HelloTriangleApp::CreateSurface()
 	if( vkCreateWin32SurfaceKHR( instance, &surfaceInfo, nullptr, &surface ) != VK_SUCCESS )
 		throw std::runtime_error( "Failed to create Surface" );*/
 
-	if( glfwCreateWindowSurface( instance, window, nullptr, &surface ) != VK_SUCCESS )
+	VkSurfaceKHR createdSurface;
+	if( glfwCreateWindowSurface( instance.Get(), window.Get(), nullptr, &createdSurface ) != VK_SUCCESS )
 		throw std::runtime_error( "Failed to create Surface" );
+	surface = UniqueSurface( instance.Get(), createdSurface );
 }
 
 void HelloTriangleApp::CreateSwapChain()
 {
 	SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport( physicalDevice );
-	VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat( swapChainSupport.format );
+	swapchainFormatChoice = ChooseSwapSurfaceFormat( swapChainSupport );
+	const VkSurfaceFormatKHR surfaceFormat = swapchainFormatChoice.surfaceFormat;
 	VkPresentModeKHR presentMode = ChooseSwapPresentMode( swapChainSupport.presentationModes );
 	VkExtent2D extent = ChooseSwapExtent( swapChainSupport.capabilities );
 
@@ -257,13 +282,25 @@ void HelloTriangleApp::CreateSwapChain()
 	// -------------
 	VkSwapchainCreateInfoKHR swapchainInfo{};
 	swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	swapchainInfo.surface = surface;
+	swapchainInfo.surface = surface.Get();
 	swapchainInfo.minImageCount = imageCount;
 	swapchainInfo.imageFormat = surfaceFormat.format;
 	swapchainInfo.imageColorSpace = surfaceFormat.colorSpace;
 	swapchainInfo.imageExtent = extent;
 	swapchainInfo.imageArrayLayers = 1;
-	swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	swapchainInfo.imageUsage = swapchainFormatChoice.usage;
+
+	// the views use the other encoding of the same format, the driver has to know both up front
+	const VkFormat viewFormats[] = { surfaceFormat.format, swapchainFormatChoice.viewFormat };
+	VkImageFormatListCreateInfoKHR formatList{};
+	if( swapchainFormatChoice.mutableFormat )
+	{
+		formatList.sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO_KHR;
+		formatList.viewFormatCount = 2;
+		formatList.pViewFormats = viewFormats;
+		swapchainInfo.flags |= VK_SWAPCHAIN_CREATE_MUTABLE_FORMAT_BIT_KHR;
+		swapchainInfo.pNext = &formatList;
+	}
 
 	QueueFamilyIndices indices = FindQueueFamilies( physicalDevice );
 	uint32_t queueFamilyIndices [] = { indices.GetGraphicsFamilyValue(), indices.GetPresentFamilyValue() };
@@ -287,27 +324,32 @@ void HelloTriangleApp::CreateSwapChain()
 
 	// Creating Swapchain
 	// ------------------
-	if( vkCreateSwapchainKHR( device, &swapchainInfo, nullptr, &swapchain ) != VK_SUCCESS )
+	VkSwapchainKHR createdSwapchain;
+	if( vkCreateSwapchainKHR( device.Get(), &swapchainInfo, nullptr, &createdSwapchain ) != VK_SUCCESS )
 		throw std::runtime_error( "Failed to create swapchain !" );
+	swapchain = UniqueSwapchain( deletionQueue, createdSwapchain );
 	// ------------------
 
 	// Retrieving Swapchain Images
 	// ---------------------------
-	vkGetSwapchainImagesKHR( device, swapchain, &imageCount, nullptr );
+	vkGetSwapchainImagesKHR( device.Get(), swapchain.Get(), &imageCount, nullptr );
 	swapchainImages.resize( imageCount );
-	vkGetSwapchainImagesKHR( device, swapchain, &imageCount, swapchainImages.data() );
+	vkGetSwapchainImagesKHR( device.Get(), swapchain.Get(), &imageCount, swapchainImages.data() );
 	// ---------------------------
 
 	// Inisialisasi beberapa member variable yang mana akan berguna pada chapter berikutnya
 	// ------------------------------------------------------------------------------------
-	swapchainFormat = surfaceFormat.format;
+	swapchainFormat = swapchainFormatChoice.viewFormat;
 	swapchainExtent = extent;
 	// ------------------------------------------------------------------------------------
+
+	std::cout << "swapchain: " << swapchainFormatChoice.Describe( extent ) << std::endl;
 }
 
 void HelloTriangleApp::CreateImageViews()
 {
-	swapchainImageViews.resize( swapchainImages.size() );
+	swapchainImageViews.clear();
+	swapchainImageViews.reserve( swapchainImages.size() );
 
 	for( size_t i = 0; i < swapchainImages.size(); ++i )
 	{
@@ -317,6 +359,15 @@ void HelloTriangleApp::CreateImageViews()
 		imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
 		imageViewInfo.format = swapchainFormat;
 
+		// a storage capable swapchain still gets sRGB views, they just cannot be used for storage
+		VkImageViewUsageCreateInfoKHR viewUsage{};
+		if( swapchainFormatChoice.viewUsage != swapchainFormatChoice.usage )
+		{
+			viewUsage.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO_KHR;
+			viewUsage.usage = swapchainFormatChoice.viewUsage;
+			imageViewInfo.pNext = &viewUsage;
+		}
+
 		// component
 		imageViewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 		imageViewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -330,8 +381,10 @@ void HelloTriangleApp::CreateImageViews()
 		imageViewInfo.subresourceRange.baseArrayLayer = 0;
 		imageViewInfo.subresourceRange.layerCount = 1;
 
-		if( vkCreateImageView( device, &imageViewInfo, nullptr, &swapchainImageViews[i] ) != VK_SUCCESS )
+		VkImageView imageView;
+		if( vkCreateImageView( device.Get(), &imageViewInfo, nullptr, &imageView ) != VK_SUCCESS )
 			throw std::runtime_error( "Failed to create imageview" );
+		swapchainImageViews.emplace_back( deletionQueue, imageView );
 	}
 }
 
@@ -344,6 +397,13 @@ std::vector<const char*> HelloTriangleApp::GetRequiredExtension()
 	if( enableValidationLayer )
 		extensions.push_back( "VK_EXT_debug_utils" );
 
+	// lets TimelineSupport::Query look at the device features on a 1.0 instance
+	for( const char* e : TimelineSupport::OptionalInstanceExtensions() )
+		extensions.push_back( e );
+	// HDR colour spaces are only reported with it
+	for( const char* e : SwapchainFormatSupport::OptionalInstanceExtensions() )
+		extensions.push_back( e );
+
 	return extensions;
 }
 
@@ -407,7 +467,7 @@ QueueFamilyIndices HelloTriangleApp::FindQueueFamilies( VkPhysicalDevice device
 		if( ( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ) && !indices.graphicsFamily.has_value() )
 			indices.graphicsFamily = i;
 
-		vkGetPhysicalDeviceSurfaceSupportKHR( device, i, surface, &isPresentSupport );
+		vkGetPhysicalDeviceSurfaceSupportKHR( device, i, surface.Get(), &isPresentSupport );
 
 		if( isPresentSupport && !indices.presentFamily.has_value() )
 			indices.presentFamily = i;
@@ -426,44 +486,43 @@ SwapChainSupportDetails HelloTriangleApp::QuerySwapChainSupport( VkPhysicalDevic
 	SwapChainSupportDetails details;
 	
 	// Get Basic Surface Capabilites details
-	vkGetPhysicalDeviceSurfaceCapabilitiesKHR( physicalDevice, surface, &details.capabilities );
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR( physicalDevice, surface.Get(), &details.capabilities );
 
 	// Get Surface Format details
 	// ----------------------
 	uint32_t surfaceFormatCount = 0;
-	vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, surface, &surfaceFormatCount, nullptr );
+	vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, surface.Get(), &surfaceFormatCount, nullptr );
 	if( surfaceFormatCount != 0 )
 	{
 		details.format.resize( static_cast<size_t>(surfaceFormatCount) );
-		vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, surface, &surfaceFormatCount, details.format.data() );
+		vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, surface.Get(), &surfaceFormatCount, details.format.data() );
 	}
 	// ----------------------
 
 	// Get Presentation Modes details
 	// --------------------------
 	uint32_t presentationModesCount = 0;
-	vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, surface, &presentationModesCount, nullptr );
+	vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, surface.Get(), &presentationModesCount, nullptr );
 	if( presentationModesCount != 0 )
 	{
 		details.presentationModes.resize( static_cast<size_t>(presentationModesCount) );
-		vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, surface, &presentationModesCount, details.presentationModes.data() );
+		vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, surface.Get(), &presentationModesCount, details.presentationModes.data() );
 	}
 	// --------------------------
 
 	return details;
 }
 
-VkSurfaceFormatKHR HelloTriangleApp::ChooseSwapSurfaceFormat( const std::vector<VkSurfaceFormatKHR>& availableSurfaceFormats )
+SwapchainFormatChoice HelloTriangleApp::ChooseSwapSurfaceFormat( const SwapChainSupportDetails& swapChainSupport )
 {
-	for( const auto& a : availableSurfaceFormats )
+	// ranking and fallbacks live in SwapchainFormatPolicy, this only decides what the app asks for
+	SwapchainFormatRequest request = swapchainFormatRequest;
+	if( const char* goal = std::getenv( "ENGINE_SWAPCHAIN_FORMAT" ) )
 	{
-		if( a.format == VK_FORMAT_B8G8R8_SRGB && a.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
-			return a;
+		if( !ParseSwapchainFormatGoal( goal, request.goal ) )
+			std::cerr << "unknown ENGINE_SWAPCHAIN_FORMAT " << goal << " ( srgb8, 10bit or hdr ), using " << ToString( request.goal ) << std::endl;
 	}
-
-	// jika VK_FORMAT_B8G8R8_SRGB dan VK_COLOR_SPACE_SRGB_NONLINEAR_KHR tidak ditemukan,
-	// maka kita me-return element array pertama dari Surface Format yang tersedia saja [pick seadanya :v]
-	return availableSurfaceFormats[0];
+	return SwapchainFormatPolicy::Choose( physicalDevice, swapChainSupport, swapchainFormatSupport, request );
 }
 
 VkPresentModeKHR HelloTriangleApp::ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes )
@@ -3,7 +3,7 @@
 //#define GLFW_EXPOSE_NATIVE_WIN32
 //#define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
-#include <glfw/glfw3.h>
+#include <GLFW/glfw3.h>
 //#include <glfw/glfw3native.h>
 
 #include <iostream>
@@ -13,10 +13,17 @@
 #include <map>
 #include <optional>
 #include <set>
+#include <limits>
+#include <cstring>
 
+#include "GlfwWindow.h"
 #include "DebugUtilsMessengerEXT.h"
 #include "QueueFamilyIndices.h"
 #include "SwapChainSupportDetails.h"
+#include "SwapchainFormat.h"
+#include "TimelineSync.h"
+#include "DeletionQueue.h"
+#include "VulkanHandle.h"
 
 // ___ VALIDATION LAYER ____
 #ifdef NDEBUG
@@ -86,7 +93,7 @@ private:
 	VkPhysicalDeviceFeatures GetPhysicalDeviceFeatures( VkPhysicalDevice physicalDevice ) const;
 	QueueFamilyIndices FindQueueFamilies( VkPhysicalDevice device );
 	SwapChainSupportDetails QuerySwapChainSupport( VkPhysicalDevice physicalDevice );
-	VkSurfaceFormatKHR ChooseSwapSurfaceFormat( const std::vector<VkSurfaceFormatKHR>& availableSurfaceFormats );
+	SwapchainFormatChoice ChooseSwapSurfaceFormat( const SwapChainSupportDetails& swapChainSupport );
 	VkPresentModeKHR ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes );
 	VkExtent2D ChooseSwapExtent( const VkSurfaceCapabilitiesKHR& capabilities );
 	// -------------
@@ -103,17 +110,29 @@ public:
 	static constexpr int ScreenWidth = 800;
 	static constexpr int ScreenHeight = 600;
 private:
-	GLFWwindow* window;
-	VkInstance instance;
-	VkDebugUtilsMessengerEXT debugMessenger;
-	VkSurfaceKHR surface;
+	// declared in creation order: members are destroyed in reverse, so every object goes before the
+	// one it was created from. Device children are handed to deletionQueue and destroyed there
+	GlfwWindow window;
+	UniqueInstance instance;
+	UniqueDebugMessenger debugMessenger;
+	UniqueSurface surface;
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-	VkDevice device;
+	UniqueDevice device;
+	SwapchainFormatSupport swapchainFormatSupport;
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
-	VkSwapchainKHR swapchain;
+
+	// every submit goes through here. Presentation has no submit of its own yet, so only graphics has a timeline
+	TimelineSync sync;
+	uint32_t graphicsTimeline = 0;
+	DeletionQueue deletionQueue;
+
+	// ENGINE_SWAPCHAIN_FORMAT=srgb8|10bit|hdr overrides the goal
+	SwapchainFormatRequest swapchainFormatRequest;
+	SwapchainFormatChoice swapchainFormatChoice;
+	UniqueSwapchain swapchain;
 	std::vector<VkImage> swapchainImages;
-	VkFormat swapchainFormat;
+	VkFormat swapchainFormat;	// the view format, what render passes and pipelines have to use
 	VkExtent2D swapchainExtent;
-	std::vector<VkImageView> swapchainImageViews;
+	std::vector<UniqueImageView> swapchainImageViews;
 };
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "MathKernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <cfloat>
+#include <initializer_list>
+#if !defined( _MSC_VER )
+#include <strings.h>
+#endif
+
+// --- SCALAR REFERENCE ---
+// ------------------------
+static void Mat4MultiplyScalar( const Mat4& a, const Mat4& b, Mat4& out )
+{
+	Mat4 r;
+	for( int c = 0; c < 4; ++c )
+	{
+		for( int row = 0; row < 4; ++row )
+		{
+			r.m[c * 4 + row] =
+				a.m[0 * 4 + row] * b.m[c * 4 + 0] +
+				a.m[1 * 4 + row] * b.m[c * 4 + 1] +
+				a.m[2 * 4 + row] * b.m[c * 4 + 2] +
+				a.m[3 * 4 + row] * b.m[c * 4 + 3];
+		}
+	}
+	out = r;
+}
+
+// cofactors through 2x2 sub determinants. The layout does not matter here,
+// inverse( transpose( M ) ) == transpose( inverse( M ) )
+static bool Mat4InverseScalar( const Mat4& m, Mat4& out )
+{
+	const float* a = m.m;
+	const float a00 = a[0], a01 = a[1], a02 = a[2], a03 = a[3];
+	const float a10 = a[4], a11 = a[5], a12 = a[6], a13 = a[7];
+	const float a20 = a[8], a21 = a[9], a22 = a[10], a23 = a[11];
+	const float a30 = a[12], a31 = a[13], a32 = a[14], a33 = a[15];
+
+	const float b00 = a00 * a11 - a01 * a10;
+	const float b01 = a00 * a12 - a02 * a10;
+	const float b02 = a00 * a13 - a03 * a10;
+	const float b03 = a01 * a12 - a02 * a11;
+	const float b04 = a01 * a13 - a03 * a11;
+	const float b05 = a02 * a13 - a03 * a12;
+	const float b06 = a20 * a31 - a21 * a30;
+	const float b07 = a20 * a32 - a22 * a30;
+	const float b08 = a20 * a33 - a23 * a30;
+	const float b09 = a21 * a32 - a22 * a31;
+	const float b10 = a21 * a33 - a23 * a31;
+	const float b11 = a22 * a33 - a23 * a32;
+
+	const float det = b00 * b11 - b01 * b10 + b02 * b09 + b03 * b08 - b04 * b07 + b05 * b06;
+	if( !( std::abs( det ) > FLT_MIN ) )
+		return false;
+	const float inv = 1.0f / det;
+
+	float* r = out.m;
+	r[0] = ( a11 * b11 - a12 * b10 + a13 * b09 ) * inv;
+	r[1] = ( a02 * b10 - a01 * b11 - a03 * b09 ) * inv;
+	r[2] = ( a31 * b05 - a32 * b04 + a33 * b03 ) * inv;
+	r[3] = ( a22 * b04 - a21 * b05 - a23 * b03 ) * inv;
+	r[4] = ( a12 * b08 - a10 * b11 - a13 * b07 ) * inv;
+	r[5] = ( a00 * b11 - a02 * b08 + a03 * b07 ) * inv;
+	r[6] = ( a32 * b02 - a30 * b05 - a33 * b01 ) * inv;
+	r[7] = ( a20 * b05 - a22 * b02 + a23 * b01 ) * inv;
+	r[8] = ( a10 * b10 - a11 * b08 + a13 * b06 ) * inv;
+	r[9] = ( a01 * b08 - a00 * b10 - a03 * b06 ) * inv;
+	r[10] = ( a30 * b04 - a31 * b02 + a33 * b00 ) * inv;
+	r[11] = ( a21 * b02 - a20 * b04 - a23 * b00 ) * inv;
+	r[12] = ( a11 * b07 - a10 * b09 - a12 * b06 ) * inv;
+	r[13] = ( a00 * b09 - a01 * b07 + a02 * b06 ) * inv;
+	r[14] = ( a31 * b01 - a30 * b03 - a32 * b00 ) * inv;
+	r[15] = ( a20 * b03 - a21 * b01 + a22 * b00 ) * inv;
+	return true;
+}
+
+static void TransformPointsScalar( const Mat4& m, const PositionsSoA& in, const PositionsSoAOut& out )
+{
+	const float* a = m.m;
+	for( size_t i = 0; i < in.count; ++i )
+	{
+		const float x = in.x[i], y = in.y[i], z = in.z[i];
+		out.x[i] = a[0] * x + a[4] * y + a[8] * z + a[12];
+		out.y[i] = a[1] * x + a[5] * y + a[9] * z + a[13];
+		out.z[i] = a[2] * x + a[6] * y + a[10] * z + a[14];
+	}
+}
+
+static size_t CullSpheresScalar( const Frustum& frustum, const SpheresSoA& spheres, uint8_t* visible )
+{
+	size_t visibleCount = 0;
+	for( size_t i = 0; i < spheres.count; ++i )
+	{
+		bool inside = true;
+		for( const Plane& p : frustum.planes )
+		{
+			const float dist = p.normal.x * spheres.centerX[i] + p.normal.y * spheres.centerY[i] + p.normal.z * spheres.centerZ[i] + p.d;
+			inside &= dist >= -spheres.radius[i];
+		}
+		visible[i] = inside ? 1 : 0;
+		visibleCount += inside ? 1 : 0;
+	}
+	return visibleCount;
+}
+
+static size_t CullAabbsScalar( const Frustum& frustum, const AabbsSoA& boxes, uint8_t* visible )
+{
+	size_t visibleCount = 0;
+	for( size_t i = 0; i < boxes.count; ++i )
+	{
+		bool inside = true;
+		for( const Plane& p : frustum.planes )
+		{
+			const float dist = p.normal.x * boxes.centerX[i] + p.normal.y * boxes.centerY[i] + p.normal.z * boxes.centerZ[i] + p.d;
+			// projected half size of the box onto the plane normal
+			const float radius = std::abs( p.normal.x ) * boxes.extentX[i] + std::abs( p.normal.y ) * boxes.extentY[i] + std::abs( p.normal.z ) * boxes.extentZ[i];
+			inside &= dist >= -radius;
+		}
+		visible[i] = inside ? 1 : 0;
+		visibleCount += inside ? 1 : 0;
+	}
+	return visibleCount;
+}
+// ------------------------
+
+const MathKernels& MathKernels::Scalar()
+{
+	static const MathKernels kernels = {
+		SimdLevel::Scalar,
+		Mat4MultiplyScalar,
+		Mat4InverseScalar,
+		TransformPointsScalar,
+		CullSpheresScalar,
+		CullAabbsScalar
+	};
+	return kernels;
+}
+
+const MathKernels* MathKernels::ForLevel( SimdLevel level )
+{
+	if( !CpuFeatures::Get().Supports( level ) )
+		return nullptr;
+
+	switch( level )
+	{
+	case SimdLevel::Scalar: return &Scalar();
+	case SimdLevel::SSE2: return GetMathKernelsSSE2();
+	case SimdLevel::AVX2: return GetMathKernelsAVX2();
+	case SimdLevel::NEON: return GetMathKernelsNEON();
+	}
+	return nullptr;
+}
+
+static const MathKernels& PickKernels()
+{
+	const char* forced = std::getenv( "ENGINE_MATH_SIMD" );
+	if( forced != nullptr )
+	{
+		for( SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON } )
+		{
+#if defined( _MSC_VER )
+			const bool match = _stricmp( forced, ToString( level ) ) == 0;
+#else
+			const bool match = strcasecmp( forced, ToString( level ) ) == 0;
+#endif
+			if( match )
+			{
+				if( const MathKernels* kernels = MathKernels::ForLevel( level ) )
+					return *kernels;
+			}
+		}
+	}
+
+	// walk down from the best level until we hit a table that was compiled in
+	for( SimdLevel level : { CpuFeatures::Get().BestLevel(), SimdLevel::SSE2, SimdLevel::NEON } )
+	{
+		if( const MathKernels* kernels = MathKernels::ForLevel( level ) )
+			return *kernels;
+	}
+	return MathKernels::Scalar();
+}
+
+const MathKernels& MathKernels::Active()
+{
+	static const MathKernels& kernels = PickKernels();
+	return kernels;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include "MathTypes.h"
+#include "CpuFeatures.h"
+
+// Structure-of-arrays views, the batch kernels work on thousands of objects per call
+// so each component is its own tightly packed stream.
+struct PositionsSoA
+{
+	const float* x;
+	const float* y;
+	const float* z;
+	size_t count;
+};
+
+struct PositionsSoAOut
+{
+	float* x;
+	float* y;
+	float* z;
+};
+
+struct SpheresSoA
+{
+	const float* centerX;
+	const float* centerY;
+	const float* centerZ;
+	const float* radius;
+	size_t count;
+};
+
+struct AabbsSoA
+{
+	const float* centerX;
+	const float* centerY;
+	const float* centerZ;
+	const float* extentX;
+	const float* extentY;
+	const float* extentZ;
+	size_t count;
+};
+
+// Table of kernels for a single instruction set. Every table computes the same results as
+// the scalar one ( up to float rounding ), pick one with Active() or ForLevel().
+struct MathKernels
+{
+public:
+	// best level supported by this CPU, chosen once on first use.
+	// ENGINE_MATH_SIMD=scalar|sse2|avx2|neon in the environment forces a lower level.
+	static const MathKernels& Active();
+	// nullptr if the level was not compiled in or the CPU does not support it
+	static const MathKernels* ForLevel( SimdLevel level );
+	static const MathKernels& Scalar();
+
+public:
+	SimdLevel level;
+
+	// out = a * b, out may alias a or b
+	void ( *Mat4Multiply )( const Mat4& a, const Mat4& b, Mat4& out );
+	// general inverse, returns false ( out untouched ) when m is singular
+	bool ( *Mat4Inverse )( const Mat4& m, Mat4& out );
+	// out = m * ( p, 1 ) for every point, out may alias in
+	void ( *TransformPoints )( const Mat4& m, const PositionsSoA& in, const PositionsSoAOut& out );
+	// visible[i] = 1 if the object touches the frustum, 0 otherwise. Returns the visible count.
+	size_t ( *CullSpheres )( const Frustum& frustum, const SpheresSoA& spheres, uint8_t* visible );
+	size_t ( *CullAabbs )( const Frustum& frustum, const AabbsSoA& boxes, uint8_t* visible );
+};
+
+// Per instruction set tables, each returns nullptr when its file was not compiled for this target
+const MathKernels* GetMathKernelsSSE2();
+const MathKernels* GetMathKernelsAVX2();
+const MathKernels* GetMathKernelsNEON();
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "MathKernels.h"
+
+// Built with AVX2 + FMA code generation for this file only ( see CMakeLists.txt / Engine.vcxproj ),
+// only ever called after CpuFeatures reported support for both.
+#if ENGINE_ARCH_X86
+#include <immintrin.h>
+
+static void Mat4MultiplyAVX2( const Mat4& a, const Mat4& b, Mat4& out )
+{
+	// every column of a duplicated into both 128 bit lanes
+	const __m256 a0 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( a.m + 0 ) );
+	const __m256 a1 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( a.m + 4 ) );
+	const __m256 a2 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( a.m + 8 ) );
+	const __m256 a3 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( a.m + 12 ) );
+
+	// two columns of b per register ( Mat4 is only 16 byte aligned, hence loadu ),
+	// the in-lane permute broadcasts element k of each column
+	const __m256 b01 = _mm256_loadu_ps( b.m + 0 );
+	const __m256 b23 = _mm256_loadu_ps( b.m + 8 );
+
+	__m256 r01 = _mm256_mul_ps( a0, _mm256_permute_ps( b01, 0x00 ) );
+	r01 = _mm256_fmadd_ps( a1, _mm256_permute_ps( b01, 0x55 ), r01 );
+	r01 = _mm256_fmadd_ps( a2, _mm256_permute_ps( b01, 0xAA ), r01 );
+	r01 = _mm256_fmadd_ps( a3, _mm256_permute_ps( b01, 0xFF ), r01 );
+
+	__m256 r23 = _mm256_mul_ps( a0, _mm256_permute_ps( b23, 0x00 ) );
+	r23 = _mm256_fmadd_ps( a1, _mm256_permute_ps( b23, 0x55 ), r23 );
+	r23 = _mm256_fmadd_ps( a2, _mm256_permute_ps( b23, 0xAA ), r23 );
+	r23 = _mm256_fmadd_ps( a3, _mm256_permute_ps( b23, 0xFF ), r23 );
+
+	_mm256_storeu_ps( out.m + 0, r01 );
+	_mm256_storeu_ps( out.m + 8, r23 );
+}
+
+static void TransformPointsAVX2( const Mat4& m, const PositionsSoA& in, const PositionsSoAOut& out )
+{
+	// e[c][r] is element ( r, c ) broadcast, the bottom row is ignored since w = 1
+	__m256 e[4][3];
+	for( int c = 0; c < 4; ++c )
+		for( int r = 0; r < 3; ++r )
+			e[c][r] = _mm256_set1_ps( m.m[c * 4 + r] );
+
+	size_t i = 0;
+	for( ; i + 8 <= in.count; i += 8 )
+	{
+		const __m256 x = _mm256_loadu_ps( in.x + i );
+		const __m256 y = _mm256_loadu_ps( in.y + i );
+		const __m256 z = _mm256_loadu_ps( in.z + i );
+
+		const __m256 ox = _mm256_fmadd_ps( e[0][0], x, _mm256_fmadd_ps( e[1][0], y, _mm256_fmadd_ps( e[2][0], z, e[3][0] ) ) );
+		const __m256 oy = _mm256_fmadd_ps( e[0][1], x, _mm256_fmadd_ps( e[1][1], y, _mm256_fmadd_ps( e[2][1], z, e[3][1] ) ) );
+		const __m256 oz = _mm256_fmadd_ps( e[0][2], x, _mm256_fmadd_ps( e[1][2], y, _mm256_fmadd_ps( e[2][2], z, e[3][2] ) ) );
+
+		_mm256_storeu_ps( out.x + i, ox );
+		_mm256_storeu_ps( out.y + i, oy );
+		_mm256_storeu_ps( out.z + i, oz );
+	}
+
+	if( i < in.count )
+	{
+		const PositionsSoA tailIn = { in.x + i, in.y + i, in.z + i, in.count - i };
+		const PositionsSoAOut tailOut = { out.x + i, out.y + i, out.z + i };
+		MathKernels::Scalar().TransformPoints( m, tailIn, tailOut );
+	}
+}
+
+static inline size_t StoreMask8( int mask, uint8_t* visible )
+{
+	size_t count = 0;
+	for( int k = 0; k < 8; ++k )
+	{
+		const uint8_t bit = static_cast<uint8_t>( ( mask >> k ) & 1 );
+		visible[k] = bit;
+		count += bit;
+	}
+	return count;
+}
+
+static size_t CullSpheresAVX2( const Frustum& frustum, const SpheresSoA& spheres, uint8_t* visible )
+{
+	__m256 nx[Frustum::Count], ny[Frustum::Count], nz[Frustum::Count], d[Frustum::Count];
+	for( int p = 0; p < Frustum::Count; ++p )
+	{
+		nx[p] = _mm256_set1_ps( frustum.planes[p].normal.x );
+		ny[p] = _mm256_set1_ps( frustum.planes[p].normal.y );
+		nz[p] = _mm256_set1_ps( frustum.planes[p].normal.z );
+		d[p] = _mm256_set1_ps( frustum.planes[p].d );
+	}
+
+	size_t visibleCount = 0;
+	size_t i = 0;
+	for( ; i + 8 <= spheres.count; i += 8 )
+	{
+		const __m256 cx = _mm256_loadu_ps( spheres.centerX + i );
+		const __m256 cy = _mm256_loadu_ps( spheres.centerY + i );
+		const __m256 cz = _mm256_loadu_ps( spheres.centerZ + i );
+		const __m256 negR = _mm256_sub_ps( _mm256_setzero_ps(), _mm256_loadu_ps( spheres.radius + i ) );
+
+		__m256 inside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+		for( int p = 0; p < Frustum::Count; ++p )
+		{
+			const __m256 dist = _mm256_fmadd_ps( nx[p], cx, _mm256_fmadd_ps( ny[p], cy, _mm256_fmadd_ps( nz[p], cz, d[p] ) ) );
+			inside = _mm256_and_ps( inside, _mm256_cmp_ps( dist, negR, _CMP_GE_OQ ) );
+		}
+		visibleCount += StoreMask8( _mm256_movemask_ps( inside ), visible + i );
+	}
+
+	if( i < spheres.count )
+	{
+		const SpheresSoA tail = { spheres.centerX + i, spheres.centerY + i, spheres.centerZ + i, spheres.radius + i, spheres.count - i };
+		visibleCount += MathKernels::Scalar().CullSpheres( frustum, tail, visible + i );
+	}
+	return visibleCount;
+}
+
+static size_t CullAabbsAVX2( const Frustum& frustum, const AabbsSoA& boxes, uint8_t* visible )
+{
+	__m256 nx[Frustum::Count], ny[Frustum::Count], nz[Frustum::Count], d[Frustum::Count];
+	__m256 ax[Frustum::Count], ay[Frustum::Count], az[Frustum::Count];
+	for( int p = 0; p < Frustum::Count; ++p )
+	{
+		const Plane& plane = frustum.planes[p];
+		nx[p] = _mm256_set1_ps( plane.normal.x );
+		ny[p] = _mm256_set1_ps( plane.normal.y );
+		nz[p] = _mm256_set1_ps( plane.normal.z );
+		d[p] = _mm256_set1_ps( plane.d );
+		ax[p] = _mm256_set1_ps( std::abs( plane.normal.x ) );
+		ay[p] = _mm256_set1_ps( std::abs( plane.normal.y ) );
+		az[p] = _mm256_set1_ps( std::abs( plane.normal.z ) );
+	}
+
+	size_t visibleCount = 0;
+	size_t i = 0;
+	for( ; i + 8 <= boxes.count; i += 8 )
+	{
+		const __m256 cx = _mm256_loadu_ps( boxes.centerX + i );
+		const __m256 cy = _mm256_loadu_ps( boxes.centerY + i );
+		const __m256 cz = _mm256_loadu_ps( boxes.centerZ + i );
+		const __m256 ex = _mm256_loadu_ps( boxes.extentX + i );
+		const __m256 ey = _mm256_loadu_ps( boxes.extentY + i );
+		const __m256 ez = _mm256_loadu_ps( boxes.extentZ + i );
+
+		__m256 inside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+		for( int p = 0; p < Frustum::Count; ++p )
+		{
+			// dist + projected radius, both folded into one FMA chain
+			__m256 v = _mm256_fmadd_ps( nx[p], cx, d[p] );
+			v = _mm256_fmadd_ps( ny[p], cy, v );
+			v = _mm256_fmadd_ps( nz[p], cz, v );
+			v = _mm256_fmadd_ps( ax[p], ex, v );
+			v = _mm256_fmadd_ps( ay[p], ey, v );
+			v = _mm256_fmadd_ps( az[p], ez, v );
+			inside = _mm256_and_ps( inside, _mm256_cmp_ps( v, _mm256_setzero_ps(), _CMP_GE_OQ ) );
+		}
+		visibleCount += StoreMask8( _mm256_movemask_ps( inside ), visible + i );
+	}
+
+	if( i < boxes.count )
+	{
+		const AabbsSoA tail = {
+			boxes.centerX + i, boxes.centerY + i, boxes.centerZ + i,
+			boxes.extentX + i, boxes.extentY + i, boxes.extentZ + i,
+			boxes.count - i };
+		visibleCount += MathKernels::Scalar().CullAabbs( frustum, tail, visible + i );
+	}
+	return visibleCount;
+}
+
+const MathKernels* GetMathKernelsAVX2()
+{
+	// a 4x4 inverse is too short to profit from 256 bit lanes, reuse the SSE2 one
+	static const MathKernels kernels = {
+		SimdLevel::AVX2,
+		Mat4MultiplyAVX2,
+		GetMathKernelsSSE2()->Mat4Inverse,
+		TransformPointsAVX2,
+		CullSpheresAVX2,
+		CullAabbsAVX2
+	};
+	return &kernels;
+}
+#else
+const MathKernels* GetMathKernelsAVX2()
+{
+	return nullptr;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "MathKernels.h"
+
+#if ENGINE_ARCH_ARM
+#include <arm_neon.h>
+#include <cfloat>
+
+static void Mat4MultiplyNEON( const Mat4& a, const Mat4& b, Mat4& out )
+{
+	const float32x4_t a0 = vld1q_f32( a.m + 0 );
+	const float32x4_t a1 = vld1q_f32( a.m + 4 );
+	const float32x4_t a2 = vld1q_f32( a.m + 8 );
+	const float32x4_t a3 = vld1q_f32( a.m + 12 );
+
+	// column c of the result is a * ( column c of b )
+	float32x4_t r[4];
+	for( int c = 0; c < 4; ++c )
+	{
+		const float32x4_t bc = vld1q_f32( b.m + c * 4 );
+		float32x4_t col = vmulq_n_f32( a0, vgetq_lane_f32( bc, 0 ) );
+		col = vmlaq_n_f32( col, a1, vgetq_lane_f32( bc, 1 ) );
+		col = vmlaq_n_f32( col, a2, vgetq_lane_f32( bc, 2 ) );
+		col = vmlaq_n_f32( col, a3, vgetq_lane_f32( bc, 3 ) );
+		r[c] = col;
+	}
+	for( int c = 0; c < 4; ++c )
+		vst1q_f32( out.m + c * 4, r[c] );
+}
+
+// 2x2 matrices packed as ( m00, m01, m10, m11 ), same block inverse as the SSE2 version.
+// NEON has no general shuffle, the swizzles are built from halves with ops ARMv7 has as well
+static inline float32x4_t Swizzle1032( float32x4_t v ) { return vrev64q_f32( v ); }
+static inline float32x4_t Swizzle2301( float32x4_t v ) { return vextq_f32( v, v, 2 ); }
+static inline float32x4_t Swizzle0303( float32x4_t v )
+{
+	const float32x2_t p = vtrn_f32( vget_low_f32( v ), vrev64_f32( vget_high_f32( v ) ) ).val[0];
+	return vcombine_f32( p, p );
+}
+static inline float32x4_t Swizzle2121( float32x4_t v )
+{
+	const float32x2_t p = vtrn_f32( vget_high_f32( v ), vrev64_f32( vget_low_f32( v ) ) ).val[0];
+	return vcombine_f32( p, p );
+}
+static inline float32x4_t Swizzle3030( float32x4_t v )
+{
+	const float32x2_t p = vtrn_f32( vrev64_f32( vget_high_f32( v ) ), vget_low_f32( v ) ).val[0];
+	return vcombine_f32( p, p );
+}
+static inline float32x4_t Swizzle3300( float32x4_t v )
+{
+	return vcombine_f32( vdup_lane_f32( vget_high_f32( v ), 1 ), vdup_lane_f32( vget_low_f32( v ), 0 ) );
+}
+static inline float32x4_t Swizzle1122( float32x4_t v )
+{
+	return vcombine_f32( vdup_lane_f32( vget_low_f32( v ), 1 ), vdup_lane_f32( vget_high_f32( v ), 0 ) );
+}
+
+// a * b
+static inline float32x4_t Mat2Mul( float32x4_t a, float32x4_t b )
+{
+	return vmlaq_f32( vmulq_f32( a, Swizzle0303( b ) ), Swizzle1032( a ), Swizzle2121( b ) );
+}
+// adjugate( a ) * b
+static inline float32x4_t Mat2AdjMul( float32x4_t a, float32x4_t b )
+{
+	return vmlsq_f32( vmulq_f32( Swizzle3300( a ), b ), Swizzle1122( a ), Swizzle2301( b ) );
+}
+// a * adjugate( b )
+static inline float32x4_t Mat2MulAdj( float32x4_t a, float32x4_t b )
+{
+	return vmlsq_f32( vmulq_f32( a, Swizzle3030( b ) ), Swizzle1032( a ), Swizzle2121( b ) );
+}
+static inline float Mat2Det( float32x4_t a )
+{
+	const float32x4_t p = vmulq_f32( a, Swizzle2301( Swizzle1032( a ) ) );	// ( a0 a3, a1 a2, .. )
+	return vgetq_lane_f32( p, 0 ) - vgetq_lane_f32( p, 1 );
+}
+
+static bool Mat4InverseNEON( const Mat4& m, Mat4& out )
+{
+	const float32x4_t r0 = vld1q_f32( m.m + 0 );
+	const float32x4_t r1 = vld1q_f32( m.m + 4 );
+	const float32x4_t r2 = vld1q_f32( m.m + 8 );
+	const float32x4_t r3 = vld1q_f32( m.m + 12 );
+
+	const float32x4_t A = vcombine_f32( vget_low_f32( r0 ), vget_low_f32( r1 ) );
+	const float32x4_t B = vcombine_f32( vget_high_f32( r0 ), vget_high_f32( r1 ) );
+	const float32x4_t C = vcombine_f32( vget_low_f32( r2 ), vget_low_f32( r3 ) );
+	const float32x4_t D = vcombine_f32( vget_high_f32( r2 ), vget_high_f32( r3 ) );
+
+	const float detA = Mat2Det( A ), detB = Mat2Det( B ), detC = Mat2Det( C ), detD = Mat2Det( D );
+
+	const float32x4_t D_C = Mat2AdjMul( D, C );
+	const float32x4_t A_B = Mat2AdjMul( A, B );
+
+	// adjugates of the result blocks
+	float32x4_t X_ = vsubq_f32( vmulq_n_f32( A, detD ), Mat2Mul( B, D_C ) );
+	float32x4_t W_ = vsubq_f32( vmulq_n_f32( D, detA ), Mat2Mul( C, A_B ) );
+	float32x4_t Y_ = vsubq_f32( vmulq_n_f32( C, detB ), Mat2MulAdj( D, A_B ) );
+	float32x4_t Z_ = vsubq_f32( vmulq_n_f32( B, detC ), Mat2MulAdj( A, D_C ) );
+
+	// |M| = |A||D| + |B||C| - tr( (A#B)(D#C) ), D_C swizzled to ( 0, 2, 1, 3 )
+	const float32x2x2_t dc = vzip_f32( vget_low_f32( D_C ), vget_high_f32( D_C ) );
+	const float32x4_t tr = vmulq_f32( A_B, vcombine_f32( dc.val[0], dc.val[1] ) );
+	const float32x2_t trPairs = vadd_f32( vget_low_f32( tr ), vget_high_f32( tr ) );
+	const float det = detA * detD + detB * detC - ( vget_lane_f32( trPairs, 0 ) + vget_lane_f32( trPairs, 1 ) );
+	if( !( std::abs( det ) > FLT_MIN ) )
+		return false;
+
+	const float rDet = 1.0f / det;
+	const float signs[4] = { rDet, -rDet, -rDet, rDet };
+	const float32x4_t rDetM = vld1q_f32( signs );
+	X_ = vmulq_f32( X_, rDetM );
+	Y_ = vmulq_f32( Y_, rDetM );
+	Z_ = vmulq_f32( Z_, rDetM );
+	W_ = vmulq_f32( W_, rDetM );
+
+	// ( X3, X1, Y3, Y1 ), ( X2, X0, Y2, Y0 ) and the same for Z / W: adjugate swizzle and store order in one
+	const float32x4x2_t xy = vuzpq_f32( X_, Y_ );
+	const float32x4x2_t zw = vuzpq_f32( Z_, W_ );
+	vst1q_f32( out.m + 0, vrev64q_f32( xy.val[1] ) );
+	vst1q_f32( out.m + 4, vrev64q_f32( xy.val[0] ) );
+	vst1q_f32( out.m + 8, vrev64q_f32( zw.val[1] ) );
+	vst1q_f32( out.m + 12, vrev64q_f32( zw.val[0] ) );
+	return true;
+}
+
+static void TransformPointsNEON( const Mat4& m, const PositionsSoA& in, const PositionsSoAOut& out )
+{
+	size_t i = 0;
+	for( ; i + 4 <= in.count; i += 4 )
+	{
+		const float32x4_t x = vld1q_f32( in.x + i );
+		const float32x4_t y = vld1q_f32( in.y + i );
+		const float32x4_t z = vld1q_f32( in.z + i );
+
+		float32x4_t ox = vmlaq_n_f32( vdupq_n_f32( m.m[12] ), x, m.m[0] );
+		ox = vmlaq_n_f32( ox, y, m.m[4] );
+		ox = vmlaq_n_f32( ox, z, m.m[8] );
+		float32x4_t oy = vmlaq_n_f32( vdupq_n_f32( m.m[13] ), x, m.m[1] );
+		oy = vmlaq_n_f32( oy, y, m.m[5] );
+		oy = vmlaq_n_f32( oy, z, m.m[9] );
+		float32x4_t oz = vmlaq_n_f32( vdupq_n_f32( m.m[14] ), x, m.m[2] );
+		oz = vmlaq_n_f32( oz, y, m.m[6] );
+		oz = vmlaq_n_f32( oz, z, m.m[10] );
+
+		vst1q_f32( out.x + i, ox );
+		vst1q_f32( out.y + i, oy );
+		vst1q_f32( out.z + i, oz );
+	}
+
+	if( i < in.count )
+	{
+		const PositionsSoA tailIn = { in.x + i, in.y + i, in.z + i, in.count - i };
+		const PositionsSoAOut tailOut = { out.x + i, out.y + i, out.z + i };
+		MathKernels::Scalar().TransformPoints( m, tailIn, tailOut );
+	}
+}
+
+static inline size_t StoreMask4( uint32x4_t mask, uint8_t* visible )
+{
+	const uint8_t v0 = vgetq_lane_u32( mask, 0 ) ? 1 : 0;
+	const uint8_t v1 = vgetq_lane_u32( mask, 1 ) ? 1 : 0;
+	const uint8_t v2 = vgetq_lane_u32( mask, 2 ) ? 1 : 0;
+	const uint8_t v3 = vgetq_lane_u32( mask, 3 ) ? 1 : 0;
+	visible[0] = v0;
+	visible[1] = v1;
+	visible[2] = v2;
+	visible[3] = v3;
+	return static_cast<size_t>( v0 + v1 + v2 + v3 );
+}
+
+static size_t CullSpheresNEON( const Frustum& frustum, const SpheresSoA& spheres, uint8_t* visible )
+{
+	size_t visibleCount = 0;
+	size_t i = 0;
+	for( ; i + 4 <= spheres.count; i += 4 )
+	{
+		const float32x4_t cx = vld1q_f32( spheres.centerX + i );
+		const float32x4_t cy = vld1q_f32( spheres.centerY + i );
+		const float32x4_t cz = vld1q_f32( spheres.centerZ + i );
+		const float32x4_t negR = vnegq_f32( vld1q_f32( spheres.radius + i ) );
+
+		uint32x4_t inside = vdupq_n_u32( 0xFFFFFFFFu );
+		for( const Plane& p : frustum.planes )
+		{
+			float32x4_t dist = vmlaq_n_f32( vdupq_n_f32( p.d ), cx, p.normal.x );
+			dist = vmlaq_n_f32( dist, cy, p.normal.y );
+			dist = vmlaq_n_f32( dist, cz, p.normal.z );
+			inside = vandq_u32( inside, vcgeq_f32( dist, negR ) );
+		}
+		visibleCount += StoreMask4( inside, visible + i );
+	}
+
+	if( i < spheres.count )
+	{
+		const SpheresSoA tail = { spheres.centerX + i, spheres.centerY + i, spheres.centerZ + i, spheres.radius + i, spheres.count - i };
+		visibleCount += MathKernels::Scalar().CullSpheres( frustum, tail, visible + i );
+	}
+	return visibleCount;
+}
+
+static size_t CullAabbsNEON( const Frustum& frustum, const AabbsSoA& boxes, uint8_t* visible )
+{
+	size_t visibleCount = 0;
+	size_t i = 0;
+	for( ; i + 4 <= boxes.count; i += 4 )
+	{
+		const float32x4_t cx = vld1q_f32( boxes.centerX + i );
+		const float32x4_t cy = vld1q_f32( boxes.centerY + i );
+		const float32x4_t cz = vld1q_f32( boxes.centerZ + i );
+		const float32x4_t ex = vld1q_f32( boxes.extentX + i );
+		const float32x4_t ey = vld1q_f32( boxes.extentY + i );
+		const float32x4_t ez = vld1q_f32( boxes.extentZ + i );
+
+		uint32x4_t inside = vdupq_n_u32( 0xFFFFFFFFu );
+		for( const Plane& p : frustum.planes )
+		{
+			float32x4_t v = vmlaq_n_f32( vdupq_n_f32( p.d ), cx, p.normal.x );
+			v = vmlaq_n_f32( v, cy, p.normal.y );
+			v = vmlaq_n_f32( v, cz, p.normal.z );
+			v = vmlaq_n_f32( v, ex, std::abs( p.normal.x ) );
+			v = vmlaq_n_f32( v, ey, std::abs( p.normal.y ) );
+			v = vmlaq_n_f32( v, ez, std::abs( p.normal.z ) );
+			inside = vandq_u32( inside, vcgeq_f32( v, vdupq_n_f32( 0.0f ) ) );
+		}
+		visibleCount += StoreMask4( inside, visible + i );
+	}
+
+	if( i < boxes.count )
+	{
+		const AabbsSoA tail = {
+			boxes.centerX + i, boxes.centerY + i, boxes.centerZ + i,
+			boxes.extentX + i, boxes.extentY + i, boxes.extentZ + i,
+			boxes.count - i };
+		visibleCount += MathKernels::Scalar().CullAabbs( frustum, tail, visible + i );
+	}
+	return visibleCount;
+}
+
+const MathKernels* GetMathKernelsNEON()
+{
+	static const MathKernels kernels = {
+		SimdLevel::NEON,
+		Mat4MultiplyNEON,
+		Mat4InverseNEON,
+		TransformPointsNEON,
+		CullSpheresNEON,
+		CullAabbsNEON
+	};
+	return &kernels;
+}
+#else
+const MathKernels* GetMathKernelsNEON()
+{
+	return nullptr;
+}
+#endif
\ No newline at end of file
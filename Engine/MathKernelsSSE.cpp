@@ -0,0 +1,235 @@
+#include "MathKernels.h"
+
+#if ENGINE_ARCH_X86
+#include <emmintrin.h>
+#include <cfloat>
+
+#define SHUFFLE_MASK( x, y, z, w ) ( ( x ) | ( ( y ) << 2 ) | ( ( z ) << 4 ) | ( ( w ) << 6 ) )
+#define SWIZZLE( v, x, y, z, w ) _mm_castsi128_ps( _mm_shuffle_epi32( _mm_castps_si128( v ), SHUFFLE_MASK( x, y, z, w ) ) )
+#define SHUFFLE( a, b, x, y, z, w ) _mm_shuffle_ps( a, b, SHUFFLE_MASK( x, y, z, w ) )
+
+// 2x2 matrices packed as ( m00, m01, m10, m11 )
+// a * b
+static inline __m128 Mat2Mul( __m128 a, __m128 b )
+{
+	return _mm_add_ps( _mm_mul_ps( a, SWIZZLE( b, 0, 3, 0, 3 ) ), _mm_mul_ps( SWIZZLE( a, 1, 0, 3, 2 ), SWIZZLE( b, 2, 1, 2, 1 ) ) );
+}
+// adjugate( a ) * b
+static inline __m128 Mat2AdjMul( __m128 a, __m128 b )
+{
+	return _mm_sub_ps( _mm_mul_ps( SWIZZLE( a, 3, 3, 0, 0 ), b ), _mm_mul_ps( SWIZZLE( a, 1, 1, 2, 2 ), SWIZZLE( b, 2, 3, 0, 1 ) ) );
+}
+// a * adjugate( b )
+static inline __m128 Mat2MulAdj( __m128 a, __m128 b )
+{
+	return _mm_sub_ps( _mm_mul_ps( a, SWIZZLE( b, 3, 0, 3, 0 ) ), _mm_mul_ps( SWIZZLE( a, 1, 0, 3, 2 ), SWIZZLE( b, 2, 1, 2, 1 ) ) );
+}
+
+// Block wise inverse on the four 2x2 sub matrices
+//     | A B |             1   | X Y |
+// M = |     |,  inv(M) = ---  |     |
+//     | C D |            |M|  | Z W |
+// Like the scalar version the storage order does not matter.
+static bool Mat4InverseSSE2( const Mat4& m, Mat4& out )
+{
+	const __m128 r0 = _mm_load_ps( m.m + 0 );
+	const __m128 r1 = _mm_load_ps( m.m + 4 );
+	const __m128 r2 = _mm_load_ps( m.m + 8 );
+	const __m128 r3 = _mm_load_ps( m.m + 12 );
+
+	const __m128 A = _mm_movelh_ps( r0, r1 );
+	const __m128 B = _mm_movehl_ps( r1, r0 );
+	const __m128 C = _mm_movelh_ps( r2, r3 );
+	const __m128 D = _mm_movehl_ps( r3, r2 );
+
+	// ( |A|, |B|, |C|, |D| )
+	const __m128 detSub = _mm_sub_ps(
+		_mm_mul_ps( SHUFFLE( r0, r2, 0, 2, 0, 2 ), SHUFFLE( r1, r3, 1, 3, 1, 3 ) ),
+		_mm_mul_ps( SHUFFLE( r0, r2, 1, 3, 1, 3 ), SHUFFLE( r1, r3, 0, 2, 0, 2 ) ) );
+	const __m128 detA = SWIZZLE( detSub, 0, 0, 0, 0 );
+	const __m128 detB = SWIZZLE( detSub, 1, 1, 1, 1 );
+	const __m128 detC = SWIZZLE( detSub, 2, 2, 2, 2 );
+	const __m128 detD = SWIZZLE( detSub, 3, 3, 3, 3 );
+
+	const __m128 D_C = Mat2AdjMul( D, C );
+	const __m128 A_B = Mat2AdjMul( A, B );
+
+	// adjugates of the result blocks
+	__m128 X_ = _mm_sub_ps( _mm_mul_ps( detD, A ), Mat2Mul( B, D_C ) );
+	__m128 W_ = _mm_sub_ps( _mm_mul_ps( detA, D ), Mat2Mul( C, A_B ) );
+	__m128 Y_ = _mm_sub_ps( _mm_mul_ps( detB, C ), Mat2MulAdj( D, A_B ) );
+	__m128 Z_ = _mm_sub_ps( _mm_mul_ps( detC, B ), Mat2MulAdj( A, D_C ) );
+
+	// |M| = |A||D| + |B||C| - tr( (A#B)(D#C) )
+	__m128 tr = _mm_mul_ps( A_B, SWIZZLE( D_C, 0, 2, 1, 3 ) );
+	tr = _mm_add_ps( tr, SWIZZLE( tr, 2, 3, 0, 1 ) );
+	tr = _mm_add_ps( tr, SWIZZLE( tr, 1, 0, 3, 2 ) );
+	const __m128 detM = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( detA, detD ), _mm_mul_ps( detB, detC ) ), tr );
+
+	const float det = _mm_cvtss_f32( detM );
+	if( !( std::abs( det ) > FLT_MIN ) )
+		return false;
+
+	const __m128 rDetM = _mm_div_ps( _mm_setr_ps( 1.0f, -1.0f, -1.0f, 1.0f ), detM );
+	X_ = _mm_mul_ps( X_, rDetM );
+	Y_ = _mm_mul_ps( Y_, rDetM );
+	Z_ = _mm_mul_ps( Z_, rDetM );
+	W_ = _mm_mul_ps( W_, rDetM );
+
+	// the adjugate swizzle and the store shuffle combined
+	_mm_store_ps( out.m + 0, SHUFFLE( X_, Y_, 3, 1, 3, 1 ) );
+	_mm_store_ps( out.m + 4, SHUFFLE( X_, Y_, 2, 0, 2, 0 ) );
+	_mm_store_ps( out.m + 8, SHUFFLE( Z_, W_, 3, 1, 3, 1 ) );
+	_mm_store_ps( out.m + 12, SHUFFLE( Z_, W_, 2, 0, 2, 0 ) );
+	return true;
+}
+
+static void TransformPointsSSE2( const Mat4& m, const PositionsSoA& in, const PositionsSoAOut& out )
+{
+	// e[c][r] is element ( r, c ) broadcast, the bottom row is ignored since w = 1
+	__m128 e[4][3];
+	for( int c = 0; c < 4; ++c )
+		for( int r = 0; r < 3; ++r )
+			e[c][r] = _mm_set1_ps( m.m[c * 4 + r] );
+
+	size_t i = 0;
+	for( ; i + 4 <= in.count; i += 4 )
+	{
+		const __m128 x = _mm_loadu_ps( in.x + i );
+		const __m128 y = _mm_loadu_ps( in.y + i );
+		const __m128 z = _mm_loadu_ps( in.z + i );
+
+		const __m128 ox = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e[0][0], x ), _mm_mul_ps( e[1][0], y ) ), _mm_add_ps( _mm_mul_ps( e[2][0], z ), e[3][0] ) );
+		const __m128 oy = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e[0][1], x ), _mm_mul_ps( e[1][1], y ) ), _mm_add_ps( _mm_mul_ps( e[2][1], z ), e[3][1] ) );
+		const __m128 oz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e[0][2], x ), _mm_mul_ps( e[1][2], y ) ), _mm_add_ps( _mm_mul_ps( e[2][2], z ), e[3][2] ) );
+
+		_mm_storeu_ps( out.x + i, ox );
+		_mm_storeu_ps( out.y + i, oy );
+		_mm_storeu_ps( out.z + i, oz );
+	}
+
+	if( i < in.count )
+	{
+		const PositionsSoA tailIn = { in.x + i, in.y + i, in.z + i, in.count - i };
+		const PositionsSoAOut tailOut = { out.x + i, out.y + i, out.z + i };
+		MathKernels::Scalar().TransformPoints( m, tailIn, tailOut );
+	}
+}
+
+static inline size_t StoreMask4( int mask, uint8_t* visible )
+{
+	size_t count = 0;
+	for( int k = 0; k < 4; ++k )
+	{
+		const uint8_t bit = static_cast<uint8_t>( ( mask >> k ) & 1 );
+		visible[k] = bit;
+		count += bit;
+	}
+	return count;
+}
+
+static size_t CullSpheresSSE2( const Frustum& frustum, const SpheresSoA& spheres, uint8_t* visible )
+{
+	__m128 nx[Frustum::Count], ny[Frustum::Count], nz[Frustum::Count], d[Frustum::Count];
+	for( int p = 0; p < Frustum::Count; ++p )
+	{
+		nx[p] = _mm_set1_ps( frustum.planes[p].normal.x );
+		ny[p] = _mm_set1_ps( frustum.planes[p].normal.y );
+		nz[p] = _mm_set1_ps( frustum.planes[p].normal.z );
+		d[p] = _mm_set1_ps( frustum.planes[p].d );
+	}
+
+	size_t visibleCount = 0;
+	size_t i = 0;
+	for( ; i + 4 <= spheres.count; i += 4 )
+	{
+		const __m128 cx = _mm_loadu_ps( spheres.centerX + i );
+		const __m128 cy = _mm_loadu_ps( spheres.centerY + i );
+		const __m128 cz = _mm_loadu_ps( spheres.centerZ + i );
+		const __m128 negR = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( spheres.radius + i ) );
+
+		__m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+		for( int p = 0; p < Frustum::Count; ++p )
+		{
+			const __m128 dist = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx[p], cx ), _mm_mul_ps( ny[p], cy ) ), _mm_add_ps( _mm_mul_ps( nz[p], cz ), d[p] ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( dist, negR ) );
+		}
+		visibleCount += StoreMask4( _mm_movemask_ps( inside ), visible + i );
+	}
+
+	if( i < spheres.count )
+	{
+		const SpheresSoA tail = { spheres.centerX + i, spheres.centerY + i, spheres.centerZ + i, spheres.radius + i, spheres.count - i };
+		visibleCount += MathKernels::Scalar().CullSpheres( frustum, tail, visible + i );
+	}
+	return visibleCount;
+}
+
+static size_t CullAabbsSSE2( const Frustum& frustum, const AabbsSoA& boxes, uint8_t* visible )
+{
+	__m128 nx[Frustum::Count], ny[Frustum::Count], nz[Frustum::Count], d[Frustum::Count];
+	__m128 ax[Frustum::Count], ay[Frustum::Count], az[Frustum::Count];
+	for( int p = 0; p < Frustum::Count; ++p )
+	{
+		const Plane& plane = frustum.planes[p];
+		nx[p] = _mm_set1_ps( plane.normal.x );
+		ny[p] = _mm_set1_ps( plane.normal.y );
+		nz[p] = _mm_set1_ps( plane.normal.z );
+		d[p] = _mm_set1_ps( plane.d );
+		ax[p] = _mm_set1_ps( std::abs( plane.normal.x ) );
+		ay[p] = _mm_set1_ps( std::abs( plane.normal.y ) );
+		az[p] = _mm_set1_ps( std::abs( plane.normal.z ) );
+	}
+
+	size_t visibleCount = 0;
+	size_t i = 0;
+	for( ; i + 4 <= boxes.count; i += 4 )
+	{
+		const __m128 cx = _mm_loadu_ps( boxes.centerX + i );
+		const __m128 cy = _mm_loadu_ps( boxes.centerY + i );
+		const __m128 cz = _mm_loadu_ps( boxes.centerZ + i );
+		const __m128 ex = _mm_loadu_ps( boxes.extentX + i );
+		const __m128 ey = _mm_loadu_ps( boxes.extentY + i );
+		const __m128 ez = _mm_loadu_ps( boxes.extentZ + i );
+
+		__m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+		for( int p = 0; p < Frustum::Count; ++p )
+		{
+			const __m128 dist = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx[p], cx ), _mm_mul_ps( ny[p], cy ) ), _mm_add_ps( _mm_mul_ps( nz[p], cz ), d[p] ) );
+			const __m128 radius = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax[p], ex ), _mm_mul_ps( ay[p], ey ) ), _mm_mul_ps( az[p], ez ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( dist, radius ), _mm_setzero_ps() ) );
+		}
+		visibleCount += StoreMask4( _mm_movemask_ps( inside ), visible + i );
+	}
+
+	if( i < boxes.count )
+	{
+		const AabbsSoA tail = {
+			boxes.centerX + i, boxes.centerY + i, boxes.centerZ + i,
+			boxes.extentX + i, boxes.extentY + i, boxes.extentZ + i,
+			boxes.count - i };
+		visibleCount += MathKernels::Scalar().CullAabbs( frustum, tail, visible + i );
+	}
+	return visibleCount;
+}
+
+const MathKernels* GetMathKernelsSSE2()
+{
+	// the scalar multiply already compiles to the same four shufps / mulps / addps columns, a hand
+	// written SSE2 version measured no faster
+	static const MathKernels kernels = {
+		SimdLevel::SSE2,
+		MathKernels::Scalar().Mat4Multiply,
+		Mat4InverseSSE2,
+		TransformPointsSSE2,
+		CullSpheresSSE2,
+		CullAabbsSSE2
+	};
+	return &kernels;
+}
+#else
+const MathKernels* GetMathKernelsSSE2()
+{
+	return nullptr;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+struct Vec3
+{
+	float x, y, z;
+};
+
+// Column-major, the same layout GLSL / Vulkan expect:
+// element (row, col) lives at m[col * 4 + row]
+struct alignas( 16 ) Mat4
+{
+	float& operator()( int row, int col ) { return m[col * 4 + row]; }
+	float operator()( int row, int col ) const { return m[col * 4 + row]; }
+
+	static Mat4 Identity()
+	{
+		Mat4 r{};
+		r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.0f;
+		return r;
+	}
+	static Mat4 Translation( float x, float y, float z )
+	{
+		Mat4 r = Identity();
+		r.m[12] = x;
+		r.m[13] = y;
+		r.m[14] = z;
+		return r;
+	}
+	static Mat4 Scale( float x, float y, float z )
+	{
+		Mat4 r{};
+		r.m[0] = x;
+		r.m[5] = y;
+		r.m[10] = z;
+		r.m[15] = 1.0f;
+		return r;
+	}
+	static Mat4 RotationY( float radians )
+	{
+		const float c = std::cos( radians );
+		const float s = std::sin( radians );
+		Mat4 r = Identity();
+		r.m[0] = c;
+		r.m[2] = -s;
+		r.m[8] = s;
+		r.m[10] = c;
+		return r;
+	}
+	// right handed, Vulkan clip space: y points down, depth 0..1
+	static Mat4 Perspective( float fovY, float aspect, float zNear, float zFar )
+	{
+		const float f = 1.0f / std::tan( fovY * 0.5f );
+		Mat4 r{};
+		r.m[0] = f / aspect;
+		r.m[5] = -f;
+		r.m[10] = zFar / ( zNear - zFar );
+		r.m[11] = -1.0f;
+		r.m[14] = ( zNear * zFar ) / ( zNear - zFar );
+		return r;
+	}
+
+public:
+	float m[16];
+};
+
+struct Plane
+{
+	// dot( normal, p ) + d >= 0 means p is on the inner side
+	Vec3 normal;
+	float d;
+};
+
+struct Frustum
+{
+	enum Side { Left, Right, Bottom, Top, Near, Far, Count };
+
+	// Gribb-Hartmann, adjusted for the Vulkan depth range ( 0 <= z <= w )
+	static Frustum FromViewProjection( const Mat4& viewProj )
+	{
+		auto row = [&viewProj]( int r, float out[4] )
+		{
+			for( int c = 0; c < 4; ++c )
+				out[c] = viewProj( r, c );
+		};
+		float r0[4], r1[4], r2[4], r3[4];
+		row( 0, r0 );
+		row( 1, r1 );
+		row( 2, r2 );
+		row( 3, r3 );
+
+		float p[Count][4];
+		for( int i = 0; i < 4; ++i )
+		{
+			p[Left][i] = r3[i] + r0[i];
+			p[Right][i] = r3[i] - r0[i];
+			p[Bottom][i] = r3[i] + r1[i];
+			p[Top][i] = r3[i] - r1[i];
+			p[Near][i] = r2[i];
+			p[Far][i] = r3[i] - r2[i];
+		}
+
+		Frustum frustum;
+		for( int i = 0; i < Count; ++i )
+		{
+			const float len = std::sqrt( p[i][0] * p[i][0] + p[i][1] * p[i][1] + p[i][2] * p[i][2] );
+			const float inv = len > 0.0f ? 1.0f / len : 0.0f;
+			frustum.planes[i] = { { p[i][0] * inv, p[i][1] * inv, p[i][2] * inv }, p[i][3] * inv };
+		}
+		return frustum;
+	}
+
+public:
+	Plane planes[Count];
+};
+
+struct Aabb
+{
+	Vec3 Center() const { return { ( min.x + max.x ) * 0.5f, ( min.y + max.y ) * 0.5f, ( min.z + max.z ) * 0.5f }; }
+	Vec3 Extent() const { return { ( max.x - min.x ) * 0.5f, ( max.y - min.y ) * 0.5f, ( max.z - min.z ) * 0.5f }; }
+
+	// Arvo: the transformed box stays axis aligned, new extent = |M| * extent
+	Aabb Transformed( const Mat4& m ) const
+	{
+		const Vec3 c = Center();
+		const Vec3 e = Extent();
+		float nc[3], ne[3];
+		for( int r = 0; r < 3; ++r )
+		{
+			nc[r] = m( r, 0 ) * c.x + m( r, 1 ) * c.y + m( r, 2 ) * c.z + m( r, 3 );
+			ne[r] = std::abs( m( r, 0 ) ) * e.x + std::abs( m( r, 1 ) ) * e.y + std::abs( m( r, 2 ) ) * e.z;
+		}
+		return { { nc[0] - ne[0], nc[1] - ne[1], nc[2] - ne[2] }, { nc[0] + ne[0], nc[1] + ne[1], nc[2] + ne[2] } };
+	}
+
+public:
+	Vec3 min;
+	Vec3 max;
+};
+
+struct Sphere
+{
+	Vec3 center;
+	float radius;
+};
\ No newline at end of file
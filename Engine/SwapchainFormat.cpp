@@ -0,0 +1,330 @@
+#include "SwapchainFormat.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <initializer_list>
+#if !defined( _MSC_VER )
+#include <strings.h>
+#endif
+
+const char* ToString( SwapchainFormatGoal goal )
+{
+	switch( goal )
+	{
+	case SwapchainFormatGoal::LowBandwidth: return "srgb8";
+	case SwapchainFormatGoal::TenBit: return "10bit";
+	case SwapchainFormatGoal::Hdr: return "hdr";
+	}
+	return "unknown";
+}
+
+bool ParseSwapchainFormatGoal( const std::string& name, SwapchainFormatGoal& goal )
+{
+	for( SwapchainFormatGoal g : { SwapchainFormatGoal::LowBandwidth, SwapchainFormatGoal::TenBit, SwapchainFormatGoal::Hdr } )
+	{
+		// case insensitive, like ENGINE_MATH_SIMD
+#if defined( _MSC_VER )
+		const bool match = _stricmp( name.c_str(), ToString( g ) ) == 0;
+#else
+		const bool match = strcasecmp( name.c_str(), ToString( g ) ) == 0;
+#endif
+		if( match )
+		{
+			goal = g;
+			return true;
+		}
+	}
+	return false;
+}
+
+// --- SUPPORT ---
+// ---------------
+static std::vector<VkExtensionProperties> DeviceExtensions( VkPhysicalDevice physicalDevice )
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, nullptr );
+	std::vector<VkExtensionProperties> extensions( extensionCount );
+	vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, extensions.data() );
+	return extensions;
+}
+
+std::vector<const char*> SwapchainFormatSupport::OptionalInstanceExtensions()
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, nullptr );
+	std::vector<VkExtensionProperties> extensions( extensionCount );
+	vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, extensions.data() );
+
+	std::vector<const char*> optional;
+	for( const auto& e : extensions )
+	{
+		if( std::strcmp( e.extensionName, VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME ) == 0 )
+			optional.push_back( VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME );
+	}
+	return optional;
+}
+
+SwapchainFormatSupport SwapchainFormatSupport::Query( VkPhysicalDevice physicalDevice )
+{
+	SwapchainFormatSupport support;
+	const std::vector<VkExtensionProperties> extensions = DeviceExtensions( physicalDevice );
+
+	// on a 1.0 device mutable format swapchains need image format lists and maintenance2 as well
+	const char* mutableFormatExtensions[] = {
+		VK_KHR_SWAPCHAIN_MUTABLE_FORMAT_EXTENSION_NAME,
+		VK_KHR_MAINTENANCE_2_EXTENSION_NAME,
+		VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME
+	};
+	support.mutableFormat = std::all_of( std::begin( mutableFormatExtensions ), std::end( mutableFormatExtensions ),
+		[&extensions]( const char* name )
+		{
+			return std::any_of( extensions.begin(), extensions.end(),
+				[name]( const VkExtensionProperties& e ) { return std::strcmp( e.extensionName, name ) == 0; } );
+		} );
+	if( support.mutableFormat )
+		support.deviceExtensions.assign( std::begin( mutableFormatExtensions ), std::end( mutableFormatExtensions ) );
+	return support;
+}
+// ---------------
+
+// --- FORMATS ---
+// ---------------
+static VkFormat SrgbVariant( VkFormat format )
+{
+	switch( format )
+	{
+	case VK_FORMAT_B8G8R8A8_UNORM: return VK_FORMAT_B8G8R8A8_SRGB;
+	case VK_FORMAT_R8G8B8A8_UNORM: return VK_FORMAT_R8G8B8A8_SRGB;
+	case VK_FORMAT_A8B8G8R8_UNORM_PACK32: return VK_FORMAT_A8B8G8R8_SRGB_PACK32;
+	default: return format;
+	}
+}
+
+static VkFormat UnormVariant( VkFormat format )
+{
+	switch( format )
+	{
+	case VK_FORMAT_B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_UNORM;
+	case VK_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_UNORM;
+	case VK_FORMAT_A8B8G8R8_SRGB_PACK32: return VK_FORMAT_A8B8G8R8_UNORM_PACK32;
+	default: return format;
+	}
+}
+
+static bool HasFeature( VkPhysicalDevice physicalDevice, VkFormat format, VkFormatFeatureFlags feature )
+{
+	VkFormatProperties properties{};
+	vkGetPhysicalDeviceFormatProperties( physicalDevice, format, &properties );
+	return ( properties.optimalTilingFeatures & feature ) == feature;
+}
+
+uint32_t SwapchainFormatPolicy::BytesPerPixel( VkFormat format )
+{
+	switch( format )
+	{
+	case VK_FORMAT_R5G6B5_UNORM_PACK16:
+	case VK_FORMAT_B5G6R5_UNORM_PACK16:
+		return 2;
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+	case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+	case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+	case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+		return 4;
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+const char* SwapchainFormatPolicy::FormatName( VkFormat format )
+{
+	switch( format )
+	{
+	case VK_FORMAT_R5G6B5_UNORM_PACK16: return "R5G6B5_UNORM";
+	case VK_FORMAT_B5G6R5_UNORM_PACK16: return "B5G6R5_UNORM";
+	case VK_FORMAT_R8G8B8A8_UNORM: return "R8G8B8A8_UNORM";
+	case VK_FORMAT_R8G8B8A8_SRGB: return "R8G8B8A8_SRGB";
+	case VK_FORMAT_B8G8R8A8_UNORM: return "B8G8R8A8_UNORM";
+	case VK_FORMAT_B8G8R8A8_SRGB: return "B8G8R8A8_SRGB";
+	case VK_FORMAT_A8B8G8R8_UNORM_PACK32: return "A8B8G8R8_UNORM";
+	case VK_FORMAT_A8B8G8R8_SRGB_PACK32: return "A8B8G8R8_SRGB";
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32: return "A2B10G10R10_UNORM";
+	case VK_FORMAT_A2R10G10B10_UNORM_PACK32: return "A2R10G10B10_UNORM";
+	case VK_FORMAT_R16G16B16A16_SFLOAT: return "R16G16B16A16_SFLOAT";
+	default: return "other";
+	}
+}
+
+const char* SwapchainFormatPolicy::ColorSpaceName( VkColorSpaceKHR colorSpace )
+{
+	switch( colorSpace )
+	{
+	case VK_COLOR_SPACE_SRGB_NONLINEAR_KHR: return "SRGB_NONLINEAR";
+	case VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT: return "EXTENDED_SRGB_LINEAR";
+	case VK_COLOR_SPACE_HDR10_ST2084_EXT: return "HDR10_ST2084";
+	default: return "other";
+	}
+}
+// ---------------
+
+// --- POLICY ---
+// --------------
+// most preferred first, each goal's list continues with the lists of the goals it falls back to
+static std::vector<VkSurfaceFormatKHR> RankedFormats( SwapchainFormatGoal goal, bool srgbView, size_t& goalEntries )
+{
+	const VkColorSpaceKHR srgb = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+	std::vector<VkSurfaceFormatKHR> ranked;
+
+	if( goal == SwapchainFormatGoal::Hdr )
+	{
+		ranked.push_back( { VK_FORMAT_R16G16B16A16_SFLOAT, VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT } );
+		ranked.push_back( { VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_COLOR_SPACE_HDR10_ST2084_EXT } );
+		ranked.push_back( { VK_FORMAT_A2R10G10B10_UNORM_PACK32, VK_COLOR_SPACE_HDR10_ST2084_EXT } );
+	}
+	if( goal == SwapchainFormatGoal::Hdr || goal == SwapchainFormatGoal::TenBit )
+	{
+		ranked.push_back( { VK_FORMAT_A2B10G10R10_UNORM_PACK32, srgb } );
+		ranked.push_back( { VK_FORMAT_A2R10G10B10_UNORM_PACK32, srgb } );
+	}
+	goalEntries = ranked.size();
+
+	// 8 bit, the encoding the caller renders with first. The other one still works through a mutable format view
+	const VkFormat eightBit[] = { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A8B8G8R8_UNORM_PACK32 };
+	for( bool srgbFirst : { srgbView, !srgbView } )
+	{
+		for( VkFormat format : eightBit )
+			ranked.push_back( { srgbFirst ? SrgbVariant( format ) : format, srgb } );
+	}
+	if( goal == SwapchainFormatGoal::LowBandwidth )
+		goalEntries = ranked.size();
+	return ranked;
+}
+
+static const char* UsageName( VkImageUsageFlags bit )
+{
+	switch( bit )
+	{
+	case VK_IMAGE_USAGE_TRANSFER_SRC_BIT: return "transfer src";
+	case VK_IMAGE_USAGE_TRANSFER_DST_BIT: return "transfer dst";
+	case VK_IMAGE_USAGE_SAMPLED_BIT: return "sampled";
+	case VK_IMAGE_USAGE_STORAGE_BIT: return "storage";
+	case VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT: return "color attachment";
+	default: return "other";
+	}
+}
+
+static std::string UsageNames( VkImageUsageFlags usage )
+{
+	std::string names;
+	for( uint32_t bit = 1; bit != 0 && bit <= usage; bit <<= 1 )
+	{
+		if( ( usage & bit ) == 0 )
+			continue;
+		if( !names.empty() )
+			names += " | ";
+		names += UsageName( bit );
+	}
+	return names;
+}
+
+SwapchainFormatChoice SwapchainFormatPolicy::Choose( VkPhysicalDevice physicalDevice, const SwapChainSupportDetails& details,
+	const SwapchainFormatSupport& support, const SwapchainFormatRequest& request )
+{
+	if( details.format.empty() )
+		throw std::runtime_error( "Failed to find a surface format" );
+
+	// a single UNDEFINED entry means the surface takes any format
+	std::vector<VkSurfaceFormatKHR> available = details.format;
+	if( available.size() == 1 && available[0].format == VK_FORMAT_UNDEFINED )
+	{
+		available = {
+			{ VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+			{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }
+		};
+	}
+	auto isAvailable = [&available]( const VkSurfaceFormatKHR& f )
+	{
+		return std::any_of( available.begin(), available.end(),
+			[&f]( const VkSurfaceFormatKHR& a ) { return a.format == f.format && a.colorSpace == f.colorSpace; } );
+	};
+
+	SwapchainFormatChoice choice;
+
+	size_t goalEntries = 0;
+	const std::vector<VkSurfaceFormatKHR> ranked = RankedFormats( request.goal, request.srgbView, goalEntries );
+	const auto best = std::find_if( ranked.begin(), ranked.end(), isAvailable );
+	if( best != ranked.end() )
+	{
+		choice.surfaceFormat = *best;
+		choice.matchedGoal = static_cast<size_t>( best - ranked.begin() ) < goalEntries;
+	}
+	else
+	{
+		// nothing we know, any sRGB nonlinear format still displays correctly
+		const auto nonlinear = std::find_if( available.begin(), available.end(),
+			[]( const VkSurfaceFormatKHR& a ) { return a.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR; } );
+		choice.surfaceFormat = nonlinear != available.end() ? *nonlinear : available[0];
+	}
+
+	// sRGB formats rarely support storage, the UNORM twin does and an sRGB view keeps rendering correct
+	const VkImageUsageFlags surfaceUsage = details.capabilities.supportedUsageFlags;
+	const bool wantsStorage = ( request.optionalUsage & surfaceUsage & VK_IMAGE_USAGE_STORAGE_BIT ) != 0;
+	if( wantsStorage && !HasFeature( physicalDevice, choice.surfaceFormat.format, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT ) )
+	{
+		const VkSurfaceFormatKHR unorm = { UnormVariant( choice.surfaceFormat.format ), choice.surfaceFormat.colorSpace };
+		const bool keepsSrgb = !request.srgbView || support.mutableFormat;
+		if( unorm.format != choice.surfaceFormat.format && keepsSrgb && isAvailable( unorm ) &&
+			HasFeature( physicalDevice, unorm.format, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT ) )
+			choice.surfaceFormat = unorm;
+	}
+
+	const VkFormat format = choice.surfaceFormat.format;
+	const VkFormat wantedView = request.srgbView ? SrgbVariant( format ) : UnormVariant( format );
+	choice.mutableFormat = wantedView != format && support.mutableFormat;
+	choice.viewFormat = choice.mutableFormat ? wantedView : format;
+
+	choice.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	for( uint32_t bit = 1; bit != 0 && bit <= request.optionalUsage; bit <<= 1 )
+	{
+		if( ( request.optionalUsage & bit ) == 0 || ( surfaceUsage & bit ) == 0 )
+			continue;
+		if( bit == VK_IMAGE_USAGE_STORAGE_BIT && !HasFeature( physicalDevice, format, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT ) )
+			continue;
+		choice.usage |= bit;
+	}
+	choice.missingUsage = request.optionalUsage & ~choice.usage;
+
+	// storage writes go through a view in the swapchain format, not through the sRGB one
+	choice.viewUsage = choice.usage;
+	if( choice.viewFormat != format && !HasFeature( physicalDevice, choice.viewFormat, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT ) )
+		choice.viewUsage &= ~VkImageUsageFlags( VK_IMAGE_USAGE_STORAGE_BIT );
+
+	choice.bytesPerPixel = BytesPerPixel( format );
+	return choice;
+}
+
+std::string SwapchainFormatChoice::Describe( VkExtent2D extent ) const
+{
+	const double frameMegabytes = static_cast<double>( extent.width ) * extent.height * bytesPerPixel / ( 1024.0 * 1024.0 );
+	char bandwidth[96];
+	std::snprintf( bandwidth, sizeof( bandwidth ), "%u B/pixel, %.2f MB/frame at %ux%u",
+		bytesPerPixel, frameMegabytes, extent.width, extent.height );
+
+	std::string text = std::string( SwapchainFormatPolicy::FormatName( surfaceFormat.format ) ) + " / " +
+		SwapchainFormatPolicy::ColorSpaceName( surfaceFormat.colorSpace ) +
+		", view " + SwapchainFormatPolicy::FormatName( viewFormat ) + ( mutableFormat ? " ( mutable format )" : "" ) +
+		", " + bandwidth + ", usage " + UsageNames( usage );
+	if( missingUsage != 0 )
+		text += ", without " + UsageNames( missingUsage );
+	if( !matchedGoal )
+		text += ", requested goal not available";
+	return text;
+}
+// --------------
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+
+#include "SwapChainSupportDetails.h"
+
+// What the swapchain format is picked for, every goal falls back to the next cheaper one when the
+// surface does not offer it: Hdr -> TenBit -> LowBandwidth
+enum class SwapchainFormatGoal
+{
+	LowBandwidth,	// 8 bit sRGB, 4 bytes per pixel
+	TenBit,			// A2B10G10R10 / A2R10G10B10 in sRGB colour space, still 4 bytes per pixel, less banding
+	Hdr				// FP16 scRGB or 10 bit HDR10, FP16 doubles the bandwidth to 8 bytes per pixel
+};
+
+const char* ToString( SwapchainFormatGoal goal );
+// false for an unknown name, accepts "srgb8", "10bit" and "hdr" in any case
+bool ParseSwapchainFormatGoal( const std::string& name, SwapchainFormatGoal& goal );
+
+struct SwapchainFormatRequest
+{
+	SwapchainFormatGoal goal = SwapchainFormatGoal::LowBandwidth;
+	// render through an sRGB view of 8 bit formats, so the hardware encodes the shader's linear output
+	bool srgbView = true;
+	// added when the surface and the format allow it, e.g. TRANSFER_SRC for capture or STORAGE for compute writes
+	VkImageUsageFlags optionalUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+};
+
+// Instance and device extensions the policy can use, see SwapchainFormatChoice::mutableFormat
+struct SwapchainFormatSupport
+{
+public:
+	// VK_EXT_swapchain_colorspace, without it surfaces only report sRGB nonlinear and Hdr is never met
+	static std::vector<const char*> OptionalInstanceExtensions();
+	static SwapchainFormatSupport Query( VkPhysicalDevice physicalDevice );
+public:
+	// VK_KHR_swapchain_mutable_format and its dependencies, add deviceExtensions to VkDeviceCreateInfo when set
+	bool mutableFormat = false;
+	std::vector<const char*> deviceExtensions;
+};
+
+struct SwapchainFormatChoice
+{
+	VkSurfaceFormatKHR surfaceFormat{};	// swapchain format and colour space
+	VkFormat viewFormat = VK_FORMAT_UNDEFINED;	// for image views, render passes and pipelines
+	// swapchain created with VK_SWAPCHAIN_CREATE_MUTABLE_FORMAT_BIT_KHR and { format, viewFormat } as format list
+	bool mutableFormat = false;
+	VkImageUsageFlags usage = 0;		// swapchain image usage
+	VkImageUsageFlags viewUsage = 0;	// usage of views in viewFormat, without what that format cannot do
+	VkImageUsageFlags missingUsage = 0;	// optional usage the surface or the format refused
+	bool matchedGoal = false;			// false when the policy fell back to a cheaper goal
+	uint32_t bytesPerPixel = 0;
+
+	// one line, e.g. "B8G8R8A8_SRGB / SRGB_NONLINEAR, view B8G8R8A8_SRGB, 4 B/pixel, 1.83 MB/frame at 800x600"
+	std::string Describe( VkExtent2D extent ) const;
+};
+
+// Ranks the surface formats for a SwapchainFormatRequest, replaces picking VK_FORMAT_B8G8R8_SRGB or the first entry
+struct SwapchainFormatPolicy
+{
+	static SwapchainFormatChoice Choose( VkPhysicalDevice physicalDevice, const SwapChainSupportDetails& details,
+		const SwapchainFormatSupport& support, const SwapchainFormatRequest& request );
+
+	// 0 for formats the policy does not know
+	static uint32_t BytesPerPixel( VkFormat format );
+	static const char* FormatName( VkFormat format );
+	static const char* ColorSpaceName( VkColorSpaceKHR colorSpace );
+};
\ No newline at end of file
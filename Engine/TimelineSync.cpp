@@ -0,0 +1,467 @@
+#include "TimelineSync.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+// --- TIMELINE SUPPORT ---
+// ------------------------
+std::vector<const char*> TimelineSupport::OptionalInstanceExtensions()
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, nullptr );
+	std::vector<VkExtensionProperties> extensions( extensionCount );
+	vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, extensions.data() );
+
+	std::vector<const char*> optional;
+	for( const auto& e : extensions )
+	{
+		if( std::strcmp( e.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME ) == 0 )
+			optional.push_back( VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME );
+	}
+	return optional;
+}
+
+TimelineSupport TimelineSupport::Query( VkInstance instance, VkPhysicalDevice physicalDevice )
+{
+	TimelineSupport support;
+	support.features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, nullptr );
+	std::vector<VkExtensionProperties> extensions( extensionCount );
+	vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, extensions.data() );
+
+	const bool hasExtension = std::any_of( extensions.begin(), extensions.end(),
+		[]( const VkExtensionProperties& e ) { return std::strcmp( e.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME ) == 0; } );
+	if( !hasExtension )
+		return support;
+
+	// the extension can be listed while the feature is off, so ask the features chain as well
+	auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+		vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceFeatures2KHR" ) );
+	if( getFeatures2 == nullptr )
+		return support;
+
+	VkPhysicalDeviceFeatures2KHR features2{};
+	features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+	features2.pNext = &support.features;
+	getFeatures2( physicalDevice, &features2 );
+
+	support.supported = support.features.timelineSemaphore == VK_TRUE;
+	support.features.pNext = nullptr;
+	return support;
+}
+// ------------------------
+
+void TimelineSync::Init( VkDevice device, bool useTimelineSemaphores )
+{
+	this->device = device;
+	useTimeline = useTimelineSemaphores;
+
+	if( useTimeline )
+	{
+		getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+			vkGetDeviceProcAddr( device, "vkGetSemaphoreCounterValueKHR" ) );
+		waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+			vkGetDeviceProcAddr( device, "vkWaitSemaphoresKHR" ) );
+		if( getSemaphoreCounterValue == nullptr || waitSemaphores == nullptr )
+			throw std::runtime_error( "Failed to load VK_KHR_timeline_semaphore functions!" );
+	}
+}
+
+void TimelineSync::CleanUp()
+{
+	if( device == VK_NULL_HANDLE )
+		return;
+
+	WaitIdle();
+	CollectRetired();
+
+	for( auto& q : queues )
+	{
+		if( q.timeline != VK_NULL_HANDLE )
+			vkDestroySemaphore( device, q.timeline, nullptr );
+		for( auto& s : q.inFlight )
+		{
+			vkDestroyFence( device, s.fence, nullptr );
+			if( s.binary != VK_NULL_HANDLE && !s.consumed )
+				vkDestroySemaphore( device, s.binary, nullptr );
+		}
+	}
+	for( auto& s : consumedSemaphores )
+		vkDestroySemaphore( device, s.semaphore, nullptr );
+	for( auto& f : freeFences )
+		vkDestroyFence( device, f, nullptr );
+	for( auto& s : freeSemaphores )
+		vkDestroySemaphore( device, s, nullptr );
+
+	queues.clear();
+	consumedSemaphores.clear();
+	freeFences.clear();
+	freeSemaphores.clear();
+	device = VK_NULL_HANDLE;
+}
+
+uint32_t TimelineSync::RegisterQueue( VkQueue queue )
+{
+	for( uint32_t i = 0; i < queues.size(); ++i )
+	{
+		if( queues[i].handle == queue )
+			return i;
+	}
+
+	Queue q;
+	q.handle = queue;
+	if( useTimeline )
+	{
+		VkSemaphoreTypeCreateInfoKHR typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		if( vkCreateSemaphore( device, &semaphoreInfo, nullptr, &q.timeline ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to create timeline semaphore!" );
+	}
+
+	queues.push_back( std::move( q ) );
+	return static_cast<uint32_t>( queues.size() - 1 );
+}
+
+TimelinePoint TimelineSync::Submit( uint32_t queue, const TimelineSubmit& submit )
+{
+	waitSemaphoreScratch.clear();
+	waitValueScratch.clear();
+	waitStageScratch.clear();
+	signalSemaphoreScratch.clear();
+	signalValueScratch.clear();
+
+	for( size_t i = 0; i < submit.binaryWaits.size(); ++i )
+	{
+		waitSemaphoreScratch.push_back( submit.binaryWaits[i] );
+		waitValueScratch.push_back( 0 );	// ignored for binary semaphores
+		waitStageScratch.push_back( i < submit.binaryWaitStages.size() ? submit.binaryWaitStages[i] : VkPipelineStageFlags( VK_PIPELINE_STAGE_ALL_COMMANDS_BIT ) );
+	}
+	for( const auto& s : submit.binarySignals )
+	{
+		signalSemaphoreScratch.push_back( s );
+		signalValueScratch.push_back( 0 );
+	}
+
+	return useTimeline ? SubmitTimeline( queue, submit ) : SubmitFallback( queue, submit );
+}
+
+TimelinePoint TimelineSync::SubmitTimeline( uint32_t queue, const TimelineSubmit& submit )
+{
+	Queue& q = queues[queue];
+
+	// one wait per semaphore with the highest value asked for, already completed points are dropped
+	const size_t firstTimelineWait = waitSemaphoreScratch.size();
+	for( const auto& w : submit.waits )
+	{
+		Queue& other = queues[w.point.queue];
+		if( w.point.value <= other.completed )
+			continue;
+
+		bool merged = false;
+		for( size_t i = firstTimelineWait; i < waitSemaphoreScratch.size(); ++i )
+		{
+			if( waitSemaphoreScratch[i] == other.timeline )
+			{
+				waitValueScratch[i] = std::max( waitValueScratch[i], w.point.value );
+				waitStageScratch[i] |= w.stage;
+				merged = true;
+			}
+		}
+		if( !merged )
+		{
+			waitSemaphoreScratch.push_back( other.timeline );
+			waitValueScratch.push_back( w.point.value );
+			waitStageScratch.push_back( w.stage );
+		}
+	}
+
+	// reserved until the submit went through, a value that is never signaled would hang every Wait on it
+	const uint64_t value = q.nextValue;
+	signalSemaphoreScratch.push_back( q.timeline );
+	signalValueScratch.push_back( value );
+
+	VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>( waitValueScratch.size() );
+	timelineInfo.pWaitSemaphoreValues = waitValueScratch.data();
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>( signalValueScratch.size() );
+	timelineInfo.pSignalSemaphoreValues = signalValueScratch.data();
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>( waitSemaphoreScratch.size() );
+	submitInfo.pWaitSemaphores = waitSemaphoreScratch.data();
+	submitInfo.pWaitDstStageMask = waitStageScratch.data();
+	submitInfo.commandBufferCount = static_cast<uint32_t>( submit.commandBuffers.size() );
+	submitInfo.pCommandBuffers = submit.commandBuffers.data();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>( signalSemaphoreScratch.size() );
+	submitInfo.pSignalSemaphores = signalSemaphoreScratch.data();
+
+	if( vkQueueSubmit( q.handle, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to submit to queue!" );
+	q.nextValue = value + 1;
+
+	return { queue, value };
+}
+
+TimelinePoint TimelineSync::SubmitFallback( uint32_t queue, const TimelineSubmit& submit )
+{
+	// reserved until the submit went through, see SubmitTimeline
+	const uint64_t value = queues[queue].nextValue;
+
+	for( const auto& w : submit.waits )
+	{
+		if( IsComplete( w.point ) )
+			continue;
+
+		// any unconsumed semaphore at or after the point covers it, queue order does the rest
+		Queue& other = queues[w.point.queue];
+		auto it = std::find_if( other.inFlight.begin(), other.inFlight.end(),
+			[&w]( const FallbackSubmission& s ) { return s.value >= w.point.value && s.binary != VK_NULL_HANDLE && !s.consumed; } );
+		if( it != other.inFlight.end() )
+		{
+			it->consumed = true;
+			consumedSemaphores.push_back( { { queue, value }, it->binary } );
+			waitSemaphoreScratch.push_back( it->binary );
+			waitStageScratch.push_back( w.stage );
+		}
+		else
+			Wait( w.point );	// not declared with crossQueueWait, or its one waiter was already taken
+	}
+
+	// a signaled semaphore nobody waits on can only be destroyed, so only signal one for a declared waiter
+	FallbackSubmission submission{ value, AcquireFence(), VK_NULL_HANDLE, false };
+	if( submit.crossQueueWait )
+	{
+		submission.binary = AcquireBinarySemaphore();
+		signalSemaphoreScratch.push_back( submission.binary );
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>( waitSemaphoreScratch.size() );
+	submitInfo.pWaitSemaphores = waitSemaphoreScratch.data();
+	submitInfo.pWaitDstStageMask = waitStageScratch.data();
+	submitInfo.commandBufferCount = static_cast<uint32_t>( submit.commandBuffers.size() );
+	submitInfo.pCommandBuffers = submit.commandBuffers.data();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>( signalSemaphoreScratch.size() );
+	submitInfo.pSignalSemaphores = signalSemaphoreScratch.data();
+
+	if( vkQueueSubmit( queues[queue].handle, 1, &submitInfo, submission.fence ) != VK_SUCCESS )
+	{
+		// neither was handed to the GPU, both are still unsignaled
+		freeFences.push_back( submission.fence );
+		if( submission.binary != VK_NULL_HANDLE )
+			freeSemaphores.push_back( submission.binary );
+		throw std::runtime_error( "Failed to submit to queue!" );
+	}
+
+	queues[queue].nextValue = value + 1;
+	queues[queue].inFlight.push_back( submission );
+	return { queue, value };
+}
+
+TimelinePoint TimelineSync::LastSubmitted( uint32_t queue ) const
+{
+	return { queue, queues[queue].nextValue - 1 };
+}
+
+uint64_t TimelineSync::CompletedValue( uint32_t queue )
+{
+	Queue& q = queues[queue];
+	if( useTimeline )
+	{
+		uint64_t value = 0;
+		if( getSemaphoreCounterValue( device, q.timeline, &value ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to read timeline semaphore!" );
+		q.completed = std::max( q.completed, value );
+	}
+	else
+		PollFallback( q );
+
+	return q.completed;
+}
+
+bool TimelineSync::IsComplete( const TimelinePoint& point )
+{
+	return point.value <= queues[point.queue].completed || point.value <= CompletedValue( point.queue );
+}
+
+void TimelineSync::Wait( const TimelinePoint& point )
+{
+	if( IsComplete( point ) )
+		return;
+
+	Queue& q = queues[point.queue];
+	if( point.value >= q.nextValue )
+		throw std::runtime_error( "Waiting for a timeline value that was never submitted!" );
+
+	CountCpuWait();
+	if( useTimeline )
+	{
+		VkSemaphoreWaitInfoKHR waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &q.timeline;
+		waitInfo.pValues = &point.value;
+
+		if( waitSemaphores( device, &waitInfo, std::numeric_limits<uint64_t>::max() ) != VK_SUCCESS )
+			throw std::runtime_error( "Failed to wait for timeline semaphore!" );
+		q.completed = std::max( q.completed, point.value );
+	}
+	else
+	{
+		// every earlier submission has to be done as well before the point counts as complete
+		for( const auto& s : q.inFlight )
+		{
+			if( s.value > point.value )
+				break;
+			if( vkWaitForFences( device, 1, &s.fence, VK_TRUE, std::numeric_limits<uint64_t>::max() ) != VK_SUCCESS )
+				throw std::runtime_error( "Failed to wait for fence!" );
+		}
+		PollFallback( q );
+	}
+}
+
+void TimelineSync::WaitIdle()
+{
+	for( uint32_t i = 0; i < queues.size(); ++i )
+		Wait( LastSubmitted( i ) );
+}
+
+void TimelineSync::Retire( const TimelinePoint& point, std::function<void()> release )
+{
+	// mostly called with the latest value, so the back is the common insertion point
+	auto& retirements = queues[point.queue].retirements;
+	auto it = std::upper_bound( retirements.begin(), retirements.end(), point.value,
+		[]( uint64_t value, const Retirement& r ) { return value < r.value; } );
+	retirements.insert( it, { point.value, std::move( release ) } );
+}
+
+size_t TimelineSync::CollectRetired()
+{
+	size_t released = 0;
+	for( uint32_t i = 0; i < queues.size(); ++i )
+	{
+		auto& retirements = queues[i].retirements;
+		if( retirements.empty() )
+			continue;
+
+		const uint64_t completed = CompletedValue( i );
+		while( !retirements.empty() && retirements.front().value <= completed )
+		{
+			// pop first, release may retire something new
+			auto release = std::move( retirements.front().release );
+			retirements.pop_front();
+			release();
+			++released;
+		}
+	}
+	return released;
+}
+
+void TimelineSync::BeginFrame()
+{
+	if( stats.frames > 0 )
+	{
+		stats.cpuWaitsLastFrame = cpuWaitsThisFrame;
+		stats.maxCpuWaitsPerFrame = std::max( stats.maxCpuWaitsPerFrame, cpuWaitsThisFrame );
+	}
+	cpuWaitsThisFrame = 0;
+	++stats.frames;
+}
+
+TimelineSync::FrameStats TimelineSync::Stats() const
+{
+	FrameStats current = stats;
+	if( current.frames > 0 )
+		current.maxCpuWaitsPerFrame = std::max( current.maxCpuWaitsPerFrame, cpuWaitsThisFrame );
+	return current;
+}
+
+void TimelineSync::PollFallback( Queue& q )
+{
+	// fences of one queue signal in submission order, stop at the first pending one
+	while( !q.inFlight.empty() && vkGetFenceStatus( device, q.inFlight.front().fence ) == VK_SUCCESS )
+	{
+		FallbackSubmission& s = q.inFlight.front();
+		vkResetFences( device, 1, &s.fence );
+		freeFences.push_back( s.fence );
+
+		// the declared waiter never came, the signaled semaphore can not be signaled again
+		if( s.binary != VK_NULL_HANDLE && !s.consumed )
+			vkDestroySemaphore( device, s.binary, nullptr );
+
+		q.completed = s.value;
+		q.inFlight.pop_front();
+	}
+
+	// consumed semaphores are unsignaled again once their waiter finished
+	const uint32_t queueIndex = static_cast<uint32_t>( &q - queues.data() );
+	for( size_t i = 0; i < consumedSemaphores.size(); )
+	{
+		const RecycledSemaphore& r = consumedSemaphores[i];
+		if( r.consumer.queue == queueIndex && r.consumer.value <= q.completed )
+		{
+			freeSemaphores.push_back( r.semaphore );
+			consumedSemaphores[i] = consumedSemaphores.back();
+			consumedSemaphores.pop_back();
+		}
+		else
+			++i;
+	}
+}
+
+VkFence TimelineSync::AcquireFence()
+{
+	if( !freeFences.empty() )
+	{
+		VkFence fence = freeFences.back();
+		freeFences.pop_back();
+		return fence;
+	}
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	VkFence fence;
+	if( vkCreateFence( device, &fenceInfo, nullptr, &fence ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to create fence!" );
+	return fence;
+}
+
+VkSemaphore TimelineSync::AcquireBinarySemaphore()
+{
+	if( !freeSemaphores.empty() )
+	{
+		VkSemaphore semaphore = freeSemaphores.back();
+		freeSemaphores.pop_back();
+		return semaphore;
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkSemaphore semaphore;
+	if( vkCreateSemaphore( device, &semaphoreInfo, nullptr, &semaphore ) != VK_SUCCESS )
+		throw std::runtime_error( "Failed to create semaphore!" );
+	return semaphore;
+}
+
+void TimelineSync::CountCpuWait()
+{
+	++cpuWaitsThisFrame;
+	++stats.totalCpuWaits;
+}
\ No newline at end of file
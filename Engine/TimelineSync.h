@@ -0,0 +1,160 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <functional>
+
+// A point on one queue's timeline, complete once every submission up to value finished on the GPU.
+// value 0 is always complete.
+struct TimelinePoint
+{
+	uint32_t queue = 0;
+	uint64_t value = 0;
+};
+
+struct TimelineWait
+{
+	TimelinePoint point;
+	VkPipelineStageFlags stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+};
+
+struct TimelineSubmit
+{
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<TimelineWait> waits;
+
+	// the swapchain only understands binary semaphores ( vkAcquireNextImageKHR / vkQueuePresentKHR )
+	std::vector<VkSemaphore> binaryWaits;
+	std::vector<VkPipelineStageFlags> binaryWaitStages;
+	std::vector<VkSemaphore> binarySignals;
+
+	// set when a submission on another queue is going to wait for this one. Only needed without timeline
+	// semaphores, where just these submissions signal a binary semaphore for the waiter
+	bool crossQueueWait = false;
+};
+
+// What CreateLogicalDevice has to enable for timeline semaphores, see TimelineSync
+struct TimelineSupport
+{
+public:
+	// needs VK_KHR_get_physical_device_properties2 enabled on the instance, otherwise reports unsupported
+	static TimelineSupport Query( VkInstance instance, VkPhysicalDevice physicalDevice );
+	// instance extensions worth enabling so Query can look at the device features
+	static std::vector<const char*> OptionalInstanceExtensions();
+public:
+	bool supported = false;
+	// chain into VkDeviceCreateInfo::pNext and add VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME when supported
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR features{};
+};
+
+// Synchronization for every queue the engine submits to. Each registered queue gets a monotonically
+// increasing timeline, submissions declare which points of other queues they wait for, and the CPU
+// only ever blocks in Wait() / WaitIdle(), which are counted per frame.
+//
+// With VK_KHR_timeline_semaphore each queue owns one timeline semaphore. Without it every submission
+// gets a fence ( CPU side completion ), submissions declared with crossQueueWait also a binary semaphore
+// that the first waiter on another queue consumes. Every other wait falls back to a CPU wait.
+class TimelineSync
+{
+public:
+	struct FrameStats
+	{
+		uint64_t frames = 0;
+		uint32_t cpuWaitsLastFrame = 0;
+		uint32_t maxCpuWaitsPerFrame = 0;
+		uint64_t totalCpuWaits = 0;
+	};
+
+public:
+	TimelineSync() = default;
+	TimelineSync( const TimelineSync& ) = delete;
+	TimelineSync& operator=( const TimelineSync& ) = delete;
+	~TimelineSync() { CleanUp(); }
+
+	void Init( VkDevice device, bool useTimelineSemaphores );
+	// waits for everything still in flight and runs the pending retirements, safe to call twice
+	void CleanUp();
+
+	// the same VkQueue registered twice ( e.g. graphics == present ) shares one timeline
+	uint32_t RegisterQueue( VkQueue queue );
+
+	TimelinePoint Submit( uint32_t queue, const TimelineSubmit& submit );
+	TimelinePoint LastSubmitted( uint32_t queue ) const;
+
+	// never block
+	uint64_t CompletedValue( uint32_t queue );
+	bool IsComplete( const TimelinePoint& point );
+
+	// block the CPU, every call that actually has to wait counts as one CPU wait
+	void Wait( const TimelinePoint& point );
+	void WaitIdle();
+
+	// release runs from CollectRetired() once point is complete
+	void Retire( const TimelinePoint& point, std::function<void()> release );
+	size_t CollectRetired();
+
+	// closes the counters of the previous frame
+	void BeginFrame();
+	// maxCpuWaitsPerFrame includes the frame still open, so the waits of the last frame are not lost
+	FrameStats Stats() const;
+	bool UsesTimelineSemaphores() const { return useTimeline; }
+
+private:
+	struct FallbackSubmission
+	{
+		uint64_t value;
+		VkFence fence;
+		VkSemaphore binary;
+		bool consumed;
+	};
+	struct RecycledSemaphore
+	{
+		TimelinePoint consumer;
+		VkSemaphore semaphore;
+	};
+	struct Retirement
+	{
+		uint64_t value;
+		std::function<void()> release;
+	};
+	struct Queue
+	{
+		VkQueue handle = VK_NULL_HANDLE;
+		uint64_t nextValue = 1;
+		uint64_t completed = 0;
+		VkSemaphore timeline = VK_NULL_HANDLE;
+		std::deque<FallbackSubmission> inFlight;
+		std::deque<Retirement> retirements;
+	};
+
+	TimelinePoint SubmitTimeline( uint32_t queue, const TimelineSubmit& submit );
+	TimelinePoint SubmitFallback( uint32_t queue, const TimelineSubmit& submit );
+	void PollFallback( Queue& queue );
+	VkFence AcquireFence();
+	VkSemaphore AcquireBinarySemaphore();
+	void CountCpuWait();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	bool useTimeline = false;
+	std::vector<Queue> queues;
+
+	PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue = nullptr;
+	PFN_vkWaitSemaphoresKHR waitSemaphores = nullptr;
+
+	// fallback pools
+	std::vector<VkFence> freeFences;
+	std::vector<VkSemaphore> freeSemaphores;
+	std::vector<RecycledSemaphore> consumedSemaphores;
+
+	// scratch, reused between submits so the hot path does not allocate
+	std::vector<VkSemaphore> waitSemaphoreScratch;
+	std::vector<uint64_t> waitValueScratch;
+	std::vector<VkPipelineStageFlags> waitStageScratch;
+	std::vector<VkSemaphore> signalSemaphoreScratch;
+	std::vector<uint64_t> signalValueScratch;
+
+	uint32_t cpuWaitsThisFrame = 0;
+	FrameStats stats;
+};
\ No newline at end of file
@@ -0,0 +1,187 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include "DeletionQueue.h"
+
+// non-dispatchable handles are pointers on 64 bit and uint64_t on 32 bit builds
+template<typename T>
+inline uint64_t HandleToU64( T handle )
+{
+	if constexpr( std::is_pointer_v<T> )
+		return static_cast<uint64_t>( reinterpret_cast<uintptr_t>( handle ) );
+	else
+		return static_cast<uint64_t>( handle );
+}
+
+template<typename T>
+inline T U64ToHandle( uint64_t value )
+{
+	if constexpr( std::is_pointer_v<T> )
+		return reinterpret_cast<T>( static_cast<uintptr_t>( value ) );
+	else
+		return static_cast<T>( value );
+}
+
+// keyed by VkObjectType and not by handle type, on 32 bit all non-dispatchable handles are the same type
+template<VkObjectType Type> struct HandleTraits;
+template<> struct HandleTraits<VK_OBJECT_TYPE_SEMAPHORE> { using Handle = VkSemaphore; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_FENCE> { using Handle = VkFence; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_DEVICE_MEMORY> { using Handle = VkDeviceMemory; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_BUFFER> { using Handle = VkBuffer; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_IMAGE> { using Handle = VkImage; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_QUERY_POOL> { using Handle = VkQueryPool; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_IMAGE_VIEW> { using Handle = VkImageView; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_SHADER_MODULE> { using Handle = VkShaderModule; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_PIPELINE_LAYOUT> { using Handle = VkPipelineLayout; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_RENDER_PASS> { using Handle = VkRenderPass; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_PIPELINE> { using Handle = VkPipeline; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT> { using Handle = VkDescriptorSetLayout; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_SAMPLER> { using Handle = VkSampler; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_DESCRIPTOR_POOL> { using Handle = VkDescriptorPool; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_FRAMEBUFFER> { using Handle = VkFramebuffer; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_COMMAND_POOL> { using Handle = VkCommandPool; };
+template<> struct HandleTraits<VK_OBJECT_TYPE_SWAPCHAIN_KHR> { using Handle = VkSwapchainKHR; };
+
+// Move-only owner of a device object. Releasing it ( Reset, destructor, move assignment ) hands the
+// handle to the DeletionQueue, which destroys it once the GPU is done with the current frame.
+// Release builds carry nothing but the handle and the queue pointer.
+template<VkObjectType Type>
+class UniqueHandle
+{
+public:
+	using Handle = typename HandleTraits<Type>::Handle;
+
+public:
+	UniqueHandle() = default;
+	UniqueHandle( DeletionQueue& owner, Handle handle ) : handle( handle ), owner( &owner )
+	{
+		if( handle != VK_NULL_HANDLE )
+			owner.Track( Type, HandleToU64( handle ) );
+	}
+	UniqueHandle( const UniqueHandle& ) = delete;
+	UniqueHandle& operator=( const UniqueHandle& ) = delete;
+	UniqueHandle( UniqueHandle&& other ) noexcept : handle( other.handle ), owner( other.owner )
+	{
+		other.handle = VK_NULL_HANDLE;
+	}
+	UniqueHandle& operator=( UniqueHandle&& other ) noexcept
+	{
+		if( this != &other )
+		{
+			Reset();
+			handle = other.handle;
+			owner = other.owner;
+			other.handle = VK_NULL_HANDLE;
+		}
+		return *this;
+	}
+	~UniqueHandle() { Reset(); }
+
+	Handle Get() const { return handle; }
+	explicit operator bool() const { return handle != VK_NULL_HANDLE; }
+
+	void Reset()
+	{
+		if( handle != VK_NULL_HANDLE )
+			owner->Enqueue( Type, HandleToU64( handle ) );
+		handle = VK_NULL_HANDLE;
+	}
+
+	// gives up ownership without destroying
+	Handle Release()
+	{
+		if( handle != VK_NULL_HANDLE )
+			owner->Untrack( Type, HandleToU64( handle ) );
+		Handle released = handle;
+		handle = VK_NULL_HANDLE;
+		return released;
+	}
+
+private:
+	Handle handle = VK_NULL_HANDLE;
+	DeletionQueue* owner = nullptr;
+};
+
+using UniqueSemaphore = UniqueHandle<VK_OBJECT_TYPE_SEMAPHORE>;
+using UniqueFence = UniqueHandle<VK_OBJECT_TYPE_FENCE>;
+using UniqueDeviceMemory = UniqueHandle<VK_OBJECT_TYPE_DEVICE_MEMORY>;
+using UniqueBuffer = UniqueHandle<VK_OBJECT_TYPE_BUFFER>;
+using UniqueImage = UniqueHandle<VK_OBJECT_TYPE_IMAGE>;
+using UniqueQueryPool = UniqueHandle<VK_OBJECT_TYPE_QUERY_POOL>;
+using UniqueImageView = UniqueHandle<VK_OBJECT_TYPE_IMAGE_VIEW>;
+using UniqueShaderModule = UniqueHandle<VK_OBJECT_TYPE_SHADER_MODULE>;
+using UniquePipelineLayout = UniqueHandle<VK_OBJECT_TYPE_PIPELINE_LAYOUT>;
+using UniqueRenderPass = UniqueHandle<VK_OBJECT_TYPE_RENDER_PASS>;
+using UniquePipeline = UniqueHandle<VK_OBJECT_TYPE_PIPELINE>;
+using UniqueDescriptorSetLayout = UniqueHandle<VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT>;
+using UniqueSampler = UniqueHandle<VK_OBJECT_TYPE_SAMPLER>;
+using UniqueDescriptorPool = UniqueHandle<VK_OBJECT_TYPE_DESCRIPTOR_POOL>;
+using UniqueFramebuffer = UniqueHandle<VK_OBJECT_TYPE_FRAMEBUFFER>;
+using UniqueCommandPool = UniqueHandle<VK_OBJECT_TYPE_COMMAND_POOL>;
+using UniqueSwapchain = UniqueHandle<VK_OBJECT_TYPE_SWAPCHAIN_KHR>;
+
+// Move-only owner of an object that is not a device child ( instance, device, surface, debug messenger ).
+// Destroyed immediately, so declare it before everything that was created from it.
+template<typename T, typename Parent, void ( *DestroyFn )( Parent, T )>
+class UniqueRootHandle
+{
+public:
+	UniqueRootHandle() = default;
+	explicit UniqueRootHandle( T handle ) : handle( handle ) {}
+	UniqueRootHandle( Parent parent, T handle ) : handle( handle ), parent( parent ) {}
+	UniqueRootHandle( const UniqueRootHandle& ) = delete;
+	UniqueRootHandle& operator=( const UniqueRootHandle& ) = delete;
+	UniqueRootHandle( UniqueRootHandle&& other ) noexcept : handle( other.handle ), parent( other.parent )
+	{
+		other.handle = VK_NULL_HANDLE;
+	}
+	UniqueRootHandle& operator=( UniqueRootHandle&& other ) noexcept
+	{
+		if( this != &other )
+		{
+			Reset();
+			handle = other.handle;
+			parent = other.parent;
+			other.handle = VK_NULL_HANDLE;
+		}
+		return *this;
+	}
+	~UniqueRootHandle() { Reset(); }
+
+	T Get() const { return handle; }
+	explicit operator bool() const { return handle != VK_NULL_HANDLE; }
+
+	void Reset()
+	{
+		if( handle != VK_NULL_HANDLE )
+			DestroyFn( parent, handle );
+		handle = VK_NULL_HANDLE;
+	}
+
+private:
+	T handle = VK_NULL_HANDLE;
+	Parent parent{};
+};
+
+namespace VulkanHandleDetail
+{
+	inline void DestroyInstance( std::nullptr_t, VkInstance instance ) { vkDestroyInstance( instance, nullptr ); }
+	inline void DestroyDevice( std::nullptr_t, VkDevice device ) { vkDestroyDevice( device, nullptr ); }
+	inline void DestroySurface( VkInstance instance, VkSurfaceKHR surface ) { vkDestroySurfaceKHR( instance, surface, nullptr ); }
+	inline void DestroyDebugMessenger( VkInstance instance, VkDebugUtilsMessengerEXT messenger )
+	{
+		// the only destroy path for the messenger, a missing function is ignored since a destructor must not throw
+		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr( instance, "vkDestroyDebugUtilsMessengerEXT" );
+		if( func != nullptr )
+			func( instance, messenger, nullptr );
+	}
+}
+
+using UniqueInstance = UniqueRootHandle<VkInstance, std::nullptr_t, &VulkanHandleDetail::DestroyInstance>;
+using UniqueDevice = UniqueRootHandle<VkDevice, std::nullptr_t, &VulkanHandleDetail::DestroyDevice>;
+using UniqueSurface = UniqueRootHandle<VkSurfaceKHR, VkInstance, &VulkanHandleDetail::DestroySurface>;
+using UniqueDebugMessenger = UniqueRootHandle<VkDebugUtilsMessengerEXT, VkInstance, &VulkanHandleDetail::DestroyDebugMessenger>;
\ No newline at end of file